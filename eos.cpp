@@ -20,6 +20,13 @@
 */
 #include "eos.h"
 
+// For the memory-mapped supernova table cache
+#include <cstdint>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 using namespace std;
 using namespace o2scl;
 using namespace o2scl_const;
@@ -44,6 +51,83 @@ eos_crust_virial_v2::eos_crust_virial_v2() {
   bpn_params[3]=4.510380054238e-01;
   bpn_params[4]=2.751333759925e-01;
   bpn_params[5]=-1.125035495140e+00;
+
+  use_tables=true;
+  tables_built=false;
+  build_tables();
+}
+
+void eos_crust_virial_v2::build_tables() {
+
+  // A dense linear grid covering the temperatures used in table
+  // generation with room to spare for the derivative stencils
+  static const size_t n_tab=4000;
+  double T_min=0.01, T_max=200.0;
+
+  T_tab.resize(n_tab);
+  bn_tab.resize(n_tab);
+  bpn_tab.resize(n_tab);
+  dbndT_tab.resize(n_tab);
+  dbpndT_tab.resize(n_tab);
+
+  for(size_t i=0;i<n_tab;i++) {
+    double T=T_min+(T_max-T_min)*((double)i)/((double)(n_tab-1));
+    T_tab[i]=T;
+    bn_tab[i]=bn_func(bn_params.size(),bn_params,T);
+    bpn_tab[i]=bpn_func(bpn_params.size(),bpn_params,T);
+    dbndT_tab[i]=bn_params[1]+2.0*bn_params[2]*T+3.0*bn_params[3]*T*T-
+      2.0*bn_params[4]*bn_params[5]*(T-bn_params[6])*
+      exp(-bn_params[5]*pow(T-bn_params[6],2.0))-
+      bn_params[7]*bn_params[8]*exp(-bn_params[8]*(T-bn_params[9]));
+    dbpndT_tab[i]=-bpn_params[0]*bpn_params[1]*2.0*(bpn_params[2]+T)*
+      exp(-bpn_params[1]*(T+bpn_params[2])*(T+bpn_params[2]))-
+      bpn_params[3]*bpn_params[4]*exp(-bpn_params[4]*(T+bpn_params[5]));
+  }
+
+  itp_bn.reset(new interp_vec<std::vector<double> >
+	       (n_tab,T_tab,bn_tab,itp_cspline));
+  itp_bpn.reset(new interp_vec<std::vector<double> >
+		(n_tab,T_tab,bpn_tab,itp_cspline));
+  itp_dbndT.reset(new interp_vec<std::vector<double> >
+		  (n_tab,T_tab,dbndT_tab,itp_cspline));
+  itp_dbpndT.reset(new interp_vec<std::vector<double> >
+		   (n_tab,T_tab,dbpndT_tab,itp_cspline));
+
+  tables_built=true;
+
+  // The registered grid values refer to the previous parameters
+  if (T_reg.size()>0) {
+    std::vector<double> T_reg_old=T_reg;
+    set_T_grid(T_reg_old);
+  }
+
+  return;
+}
+
+void eos_crust_virial_v2::set_T_grid(const std::vector<double> &T_grid) {
+
+  T_reg=T_grid;
+  std::sort(T_reg.begin(),T_reg.end());
+
+  size_t n=T_reg.size();
+  bn_reg.resize(n);
+  bpn_reg.resize(n);
+  dbndT_reg.resize(n);
+  dbpndT_reg.resize(n);
+
+  // Temporarily disable the tables so the registered values come
+  // from the analytic functions
+  bool ut=use_tables;
+  use_tables=false;
+  for(size_t i=0;i<n;i++) {
+    bn_reg[i]=bn_f(T_reg[i]);
+    bpn_reg[i]=bpn_f(T_reg[i]);
+    dbndT_reg[i]=dbndT_f(T_reg[i]);
+    dbpndT_reg[i]=dbpndT_f(T_reg[i]);
+  }
+  use_tables=ut;
+
+  return;
 }
 
 double eos_crust_virial_v2::bn_func(size_t np, const vector<double> &par,
@@ -59,14 +143,35 @@ double eos_crust_virial_v2::bpn_func(size_t np, const vector<double> &par,
 }
 
 double eos_crust_virial_v2::bn_f(double T) {
+  if (use_tables && tables_built) {
+    int ir=reg_index(T);
+    if (ir>=0) return bn_reg[ir];
+    if (T>=T_tab[0] && T<=T_tab[T_tab.size()-1]) {
+      return itp_bn->eval(T);
+    }
+  }
   return bn_func(bn_params.size(),bn_params,T);
 }
 
 double eos_crust_virial_v2::bpn_f(double T) {
+  if (use_tables && tables_built) {
+    int ir=reg_index(T);
+    if (ir>=0) return bpn_reg[ir];
+    if (T>=T_tab[0] && T<=T_tab[T_tab.size()-1]) {
+      return itp_bpn->eval(T);
+    }
+  }
   return bpn_func(bpn_params.size(),bpn_params,T);
 }
 
 double eos_crust_virial_v2::dbndT_f(double T) {
+  if (use_tables && tables_built) {
+    int ir=reg_index(T);
+    if (ir>=0) return dbndT_reg[ir];
+    if (T>=T_tab[0] && T<=T_tab[T_tab.size()-1]) {
+      return itp_dbndT->eval(T);
+    }
+  }
   return bn_params[1]+2.0*bn_params[2]*T+3.0*bn_params[3]*T*T-
     2.0*bn_params[4]*bn_params[5]*(T-bn_params[6])*
     exp(-bn_params[5]*pow(T-bn_params[6],2.0))-
@@ -74,11 +179,425 @@ double eos_crust_virial_v2::dbndT_f(double T) {
 }
 
 double eos_crust_virial_v2::dbpndT_f(double T) {
+  if (use_tables && tables_built) {
+    int ir=reg_index(T);
+    if (ir>=0) return dbpndT_reg[ir];
+    if (T>=T_tab[0] && T<=T_tab[T_tab.size()-1]) {
+      return itp_dbpndT->eval(T);
+    }
+  }
   return -bpn_params[0]*bpn_params[1]*2.0*(bpn_params[2]+T)*
     exp(-bpn_params[1]*(T+bpn_params[2])*(T+bpn_params[2]))-
     bpn_params[3]*bpn_params[4]*exp(-bpn_params[4]*(T+bpn_params[5]));
 }
 
+void lepton_table::build(fermion &e, fermion_rel &relf) {
+
+  // Load from the sidecar file if one is present and matches
+  // the grid sizes
+  if (cache_file.length()>0) {
+    std::ifstream fin(cache_file.c_str());
+    bool cache_exists=fin.good();
+    fin.close();
+    if (cache_exists) {
+      hdf_file hf;
+      hf.open(cache_file);
+      hdf_input(hf,tab,"lepton_eos");
+      hf.close();
+      if (tab.get_nx()==n_ne && tab.get_ny()==n_T) {
+	built=true;
+	cout << "Loaded lepton table from " << cache_file
+	     << "." << endl;
+	return;
+      }
+      cout << "Lepton table in " << cache_file
+	   << " does not match the grid, rebuilding." << endl;
+    }
+  }
+
+  // Log-log grid in fm units, covering the densities and
+  // temperatures reached in table generation
+  std::vector<double> lne_grid(n_ne), lT_grid(n_T);
+  for(size_t i=0;i<n_ne;i++) {
+    lne_grid[i]=-15.0+15.5*((double)i)/((double)(n_ne-1));
+  }
+  for(size_t j=0;j<n_T;j++) {
+    lT_grid[j]=-4.0+4.0*((double)j)/((double)(n_T-1));
+  }
+
+  tab.clear();
+  tab.set_xy("log_ne",n_ne,lne_grid,"log_T",n_T,lT_grid);
+  tab.new_slice("log_ed");
+  tab.new_slice("log_pr");
+  tab.new_slice("log_en");
+  tab.new_slice("log_mue");
+
+  for(size_t i=0;i<n_ne;i++) {
+    for(size_t j=0;j<n_T;j++) {
+      e.n=pow(10.0,lne_grid[i]);
+      e.mu=e.m;
+      relf.pair_density(e,pow(10.0,lT_grid[j]));
+      tab.set(i,j,"log_ed",log10(e.ed));
+      tab.set(i,j,"log_pr",log10(e.pr));
+      tab.set(i,j,"log_en",log10(e.en));
+      tab.set(i,j,"log_mue",log10(e.mu));
+    }
+  }
+
+  built=true;
+
+  if (cache_file.length()>0) {
+    hdf_file hf;
+    hf.open_or_create(cache_file);
+    hdf_output(hf,tab,"lepton_eos");
+    hf.close();
+    cout << "Wrote lepton table to " << cache_file << "." << endl;
+  }
+
+  return;
+}
+
+double lepton_table::max_dev(fermion &e, fermion_rel &relf) {
+
+  double dev=0.0;
+
+  // Sample cell midpoints, which are the points farthest from
+  // the interpolation nodes
+  for(size_t i=0;i<n_ne-1;i+=8) {
+    for(size_t j=0;j<n_T-1;j+=8) {
+      double lne=(tab.get_x_data()[i]+tab.get_x_data()[i+1])/2.0;
+      double lT=(tab.get_y_data()[j]+tab.get_y_data()[j+1])/2.0;
+      double ne=pow(10.0,lne), T=pow(10.0,lT);
+      double ed, pr, en, mue;
+      if (get(ne,T,ed,pr,en,mue)) {
+	e.n=ne;
+	e.mu=e.m;
+	relf.pair_density(e,T);
+	double d;
+	d=fabs(ed-e.ed)/fabs(e.ed);
+	if (d>dev) dev=d;
+	d=fabs(pr-e.pr)/fabs(e.pr);
+	if (d>dev) dev=d;
+	d=fabs(en-e.en)/fabs(e.en);
+	if (d>dev) dev=d;
+	d=fabs(mue-e.mu)/fabs(e.mu);
+	if (d>dev) dev=d;
+      }
+    }
+  }
+
+  return dev;
+}
+
+async_block_writer::async_block_writer() {
+  pending=false;
+  stop=false;
+  running=false;
+  pend_i=0;
+}
+
+async_block_writer::~async_block_writer() {
+  finish();
+}
+
+void async_block_writer::start
+(std::function<void(size_t,const std::vector<double> &)> f) {
+  if (running) finish();
+  write_fn=f;
+  pending=false;
+  stop=false;
+  running=true;
+  th=std::thread(&async_block_writer::run,this);
+  return;
+}
+
+void async_block_writer::run() {
+  std::unique_lock<std::mutex> lock(mtx);
+  while (true) {
+    while (pending==false && stop==false) cv.wait(lock);
+    if (pending) {
+      size_t i=pend_i;
+      std::vector<double> buf;
+      buf.swap(pend_buf);
+      // Write without the lock held so push() can refill the
+      // hand-off buffer while the write is in flight
+      lock.unlock();
+      write_fn(i,buf);
+      lock.lock();
+      pending=false;
+      cv.notify_all();
+    } else {
+      break;
+    }
+  }
+  return;
+}
+
+void async_block_writer::push(size_t i, const std::vector<double> &v) {
+  if (running==false) {
+    O2SCL_ERR("No thread started in async_block_writer::push().",
+	      o2scl::exc_einval);
+  }
+  std::unique_lock<std::mutex> lock(mtx);
+  while (pending) cv.wait(lock);
+  pend_i=i;
+  pend_buf=v;
+  pending=true;
+  cv.notify_all();
+  return;
+}
+
+void async_block_writer::finish() {
+  if (running==false) return;
+  {
+    std::unique_lock<std::mutex> lock(mtx);
+    while (pending) cv.wait(lock);
+    stop=true;
+    cv.notify_all();
+  }
+  th.join();
+  running=false;
+  return;
+}
+
+void table_append_writer::open(std::string fname) {
+  hf.open_or_create(fname);
+  buf.clear();
+  n_cols=0;
+  n_rows=0;
+  n_blocks=0;
+  is_open=true;
+  abw.start([this](size_t i, const std::vector<double> &v) {
+      hf.setd_vec(((string)"block_")+szttos(i),v);
+      hf.set_szt("n_blocks",i+1);
+      hf.set_szt("n_cols",n_cols);
+    });
+  return;
+}
+
+void table_append_writer::append(const std::vector<double> &row) {
+  if (is_open==false) {
+    O2SCL_ERR("No file opened in table_append_writer::append().",
+	      o2scl::exc_einval);
+  }
+  if (n_cols==0) {
+    n_cols=row.size();
+  } else if (row.size()!=n_cols) {
+    O2SCL_ERR("Row size mismatch in table_append_writer::append().",
+	      o2scl::exc_einval);
+  }
+  for(size_t i=0;i<row.size();i++) buf.push_back(row[i]);
+  n_rows++;
+  if (n_rows>=flush_interval) flush();
+  return;
+}
+
+void table_append_writer::flush() {
+  if (n_rows==0) return;
+  abw.push(n_blocks,buf);
+  n_blocks++;
+  buf.clear();
+  n_rows=0;
+  return;
+}
+
+void table_append_writer::finish(o2scl::table<> &t, std::string name) {
+  flush();
+  // The writer thread must be joined before the file is touched
+  // from this thread again
+  abw.finish();
+  hdf_output(hf,t,name);
+  hf.close();
+  is_open=false;
+  return;
+}
+
+/// Magic number identifying the sidecar format ("sntbch01")
+static const uint64_t sn_cache_magic=0x736e746263683031ULL;
+
+void sn_table_cache::build(std::string fname, eos_sn_oo &eso) {
+
+  string bin_fname=fname+".bin";
+  FILE *fp=fopen(bin_fname.c_str(),"wb");
+  if (fp==0) {
+    O2SCL_ERR("Could not create sidecar in sn_table_cache::build().",
+	      exc_efailed);
+  }
+
+  uint64_t header[4]={sn_cache_magic,eso.F.get_size(0),
+		      eso.F.get_size(1),eso.F.get_size(2)};
+  fwrite(header,sizeof(uint64_t),4,fp);
+
+  size_t sz[3]={((size_t)header[1]),((size_t)header[2]),
+		((size_t)header[3])};
+  vector<double> tmp;
+  for(size_t ell=0;ell<3;ell++) {
+    tmp.resize(sz[ell]);
+    for(size_t i=0;i<sz[ell];i++) tmp[i]=eso.F.get_grid(ell,i);
+    fwrite(&tmp[0],sizeof(double),sz[ell],fp);
+  }
+
+  tensor_grid3<> *tens[4]={&eso.F,&eso.Fint,&eso.Xn,&eso.Xalpha};
+  tmp.resize(sz[2]);
+  for(size_t iq=0;iq<4;iq++) {
+    for(size_t i=0;i<sz[0];i++) {
+      for(size_t j=0;j<sz[1];j++) {
+	for(size_t k=0;k<sz[2];k++) {
+	  tmp[k]=tens[iq]->get(i,j,k);
+	}
+	fwrite(&tmp[0],sizeof(double),sz[2],fp);
+      }
+    }
+  }
+
+  fclose(fp);
+  return;
+}
+
+bool sn_table_cache::attach(std::string fname) {
+
+  close();
+
+  string bin_fname=fname+".bin";
+  fd=open(bin_fname.c_str(),O_RDONLY);
+  if (fd<0) return false;
+
+  struct stat sb;
+  if (fstat(fd,&sb)!=0) {
+    ::close(fd);
+    fd=-1;
+    return false;
+  }
+  map_len=sb.st_size;
+
+  // A shared read-only mapping, so the pages live in the kernel
+  // page cache and are shared across processes
+  map_ptr=mmap(0,map_len,PROT_READ,MAP_SHARED,fd,0);
+  if (map_ptr==MAP_FAILED) {
+    ::close(fd);
+    fd=-1;
+    map_ptr=0;
+    return false;
+  }
+
+  const uint64_t *header=(const uint64_t *)map_ptr;
+  n_nB=((size_t)header[1]);
+  n_Ye=((size_t)header[2]);
+  n_T=((size_t)header[3]);
+  size_t expect=4*sizeof(uint64_t)+
+    (n_nB+n_Ye+n_T+4*n_nB*n_Ye*n_T)*sizeof(double);
+  if (header[0]!=sn_cache_magic || map_len!=expect) {
+    close();
+    return false;
+  }
+
+  const double *dp=(const double *)(header+4);
+  nB_grid=dp;
+  Ye_grid=nB_grid+n_nB;
+  T_grid=Ye_grid+n_Ye;
+  for(size_t iq=0;iq<4;iq++) {
+    data[iq]=T_grid+n_T+iq*n_nB*n_Ye*n_T;
+  }
+
+  is_mapped=true;
+  return true;
+}
+
+double sn_table_cache::interp_linear(size_t iq, double nB, double Ye,
+				     double T) {
+
+  if (is_mapped==false || iq>=4) {
+    O2SCL_ERR("No mapped table in sn_table_cache::interp_linear().",
+	      exc_einval);
+  }
+
+  // Bracketing indices and weights in each dimension, clamping
+  // to the grid boundaries
+  const double *grids[3]={nB_grid,Ye_grid,T_grid};
+  size_t sz[3]={n_nB,n_Ye,n_T};
+  double val[3]={nB,Ye,T};
+  size_t ix[3];
+  double wgt[3];
+  for(size_t ell=0;ell<3;ell++) {
+    const double *g=grids[ell];
+    size_t n=sz[ell];
+    if (val[ell]<=g[0]) {
+      ix[ell]=0;
+      wgt[ell]=0.0;
+    } else if (val[ell]>=g[n-1]) {
+      ix[ell]=n-2;
+      wgt[ell]=1.0;
+    } else {
+      const double *it=std::lower_bound(g,g+n,val[ell]);
+      ix[ell]=((size_t)(it-g))-1;
+      wgt[ell]=(val[ell]-g[ix[ell]])/(g[ix[ell]+1]-g[ix[ell]]);
+    }
+  }
+
+  const double *dp=data[iq];
+  double res=0.0;
+  for(size_t di=0;di<2;di++) {
+    for(size_t dj=0;dj<2;dj++) {
+      for(size_t dk=0;dk<2;dk++) {
+	double w=(di==0?1.0-wgt[0]:wgt[0])*
+	  (dj==0?1.0-wgt[1]:wgt[1])*
+	  (dk==0?1.0-wgt[2]:wgt[2]);
+	res+=w*dp[((ix[0]+di)*n_Ye+ix[1]+dj)*n_T+ix[2]+dk];
+      }
+    }
+  }
+
+  return res;
+}
+
+void sn_table_cache::close() {
+  if (is_mapped || map_ptr!=0) {
+    munmap(map_ptr,map_len);
+  }
+  if (fd>=0) {
+    ::close(fd);
+  }
+  fd=-1;
+  map_ptr=0;
+  map_len=0;
+  is_mapped=false;
+  return;
+}
+
+const char *eos_stats::name(size_t k) {
+  static const char *names[n_ker]={"free_energy_density",
+				   "solve_fugacity","cs2_fixYe",
+				   "skyrme_Tcorr","electron",
+				   "table_point"};
+  if (k>=n_ker) {
+    O2SCL_ERR("Invalid kernel index in eos_stats::name().",
+	      o2scl::exc_einval);
+  }
+  return names[k];
+}
+
+void eos_stats::report() const {
+  for(size_t k=0;k<n_ker;k++) {
+    if (n_calls[k]>0) {
+      cout << "stats " << name(k) << " " << n_calls[k] << " "
+	   << ns_tot[k]/((double)n_calls[k]) << " "
+	   << ns_tot[k]*1.0e-9 << endl;
+    }
+  }
+  return;
+}
+
+void eos_stats::hdf_out(o2scl_hdf::hdf_file &hf) const {
+  std::vector<double> calls(n_ker), ns(n_ker);
+  for(size_t k=0;k<n_ker;k++) {
+    calls[k]=((double)n_calls[k]);
+    ns[k]=ns_tot[k];
+  }
+  hf.setd_vec("stats_calls",calls);
+  hf.setd_vec("stats_ns",ns);
+  return;
+}
+
 void eos_crust_virial_v2::fit(bool show_fit) {
 
   // Chi squared
@@ -308,6 +827,9 @@ void eos_crust_virial_v2::fit(bool show_fit) {
     hf.close();
   }
   
+  // Rebuild the coefficient tables for the new parameters
+  build_tables();
+
   // End of eos_crust_virial_v2::fit()
   return;
 }
@@ -324,10 +846,18 @@ double eos::fit_fun(size_t np, const std::vector<double> &parms,
 }
 
 double eos::ed_fit(double nb) {
+  if (use_fit_splines && fit_splines_built &&
+      nb>=fit_spline_nb_lo && nb<=fit_spline_nb_hi) {
+    return itp_ed_fit->eval(nb);
+  }
   return fit_fun(5,ns_fit_parms,nb)*nb/hc_mev_fm;
 }
 
 double eos::mu_fit(double nb) {
+  if (use_fit_splines && fit_splines_built &&
+      nb>=fit_spline_nb_lo && nb<=fit_spline_nb_hi) {
+    return itp_mu_fit->eval(nb);
+  }
   if (old_ns_fit) {
     return (1.5*sqrt(nb)*ns_fit_parms[0]+2.0*nb*ns_fit_parms[1]+
 	    2.5*nb*sqrt(nb)*ns_fit_parms[2]+3.0*nb*nb*ns_fit_parms[3]+
@@ -341,6 +871,10 @@ double eos::mu_fit(double nb) {
 }
 
 double eos::dmudn_fit(double nb) {
+  if (use_fit_splines && fit_splines_built &&
+      nb>=fit_spline_nb_lo && nb<=fit_spline_nb_hi) {
+    return itp_dmudn_fit->eval(nb);
+  }
   if (old_ns_fit) {
     return (0.75/sqrt(nb)*ns_fit_parms[0]+2.0*ns_fit_parms[1]+
 	    3.75*sqrt(nb)*ns_fit_parms[2]+6.0*nb*ns_fit_parms[3]+
@@ -352,9 +886,72 @@ double eos::dmudn_fit(double nb) {
 }
 
 double eos::cs2_fit(double nb) {
+  if (use_fit_splines && fit_splines_built &&
+      nb>=fit_spline_nb_lo && nb<=fit_spline_nb_hi) {
+    return itp_cs2_fit->eval(nb);
+  }
   return dmudn_fit(nb)*nb/(mu_fit(nb)+939.565/hc_mev_fm);
 }
 
+void eos::build_fit_splines() {
+
+  // The tabulation range comfortably covers the densities used in
+  // new_ns_eos() and min_max_cs2(). The lower limit is kept away
+  // from zero because the old fit form has a sqrt(nb) term whose
+  // derivatives are singular there.
+  static const size_t n_tab=2000;
+  fit_spline_nb_lo=0.01;
+  fit_spline_nb_hi=2.5;
+
+  fit_nb_tab.resize(n_tab);
+  ed_fit_tab.resize(n_tab);
+  mu_fit_tab.resize(n_tab);
+  dmudn_fit_tab.resize(n_tab);
+  cs2_fit_tab.resize(n_tab);
+
+  // Evaluate the analytic forms while filling the tables
+  fit_splines_built=false;
+
+  for(size_t i=0;i<n_tab;i++) {
+    double nb=fit_spline_nb_lo+(fit_spline_nb_hi-fit_spline_nb_lo)*
+      ((double)i)/((double)(n_tab-1));
+    fit_nb_tab[i]=nb;
+    ed_fit_tab[i]=ed_fit(nb);
+    mu_fit_tab[i]=mu_fit(nb);
+    dmudn_fit_tab[i]=dmudn_fit(nb);
+    cs2_fit_tab[i]=cs2_fit(nb);
+  }
+
+  itp_ed_fit.reset(new interp_vec<std::vector<double> >
+		   (n_tab,fit_nb_tab,ed_fit_tab,itp_cspline));
+  itp_mu_fit.reset(new interp_vec<std::vector<double> >
+		   (n_tab,fit_nb_tab,mu_fit_tab,itp_cspline));
+  itp_dmudn_fit.reset(new interp_vec<std::vector<double> >
+		      (n_tab,fit_nb_tab,dmudn_fit_tab,itp_cspline));
+  itp_cs2_fit.reset(new interp_vec<std::vector<double> >
+		    (n_tab,fit_nb_tab,cs2_fit_tab,itp_cspline));
+
+  fit_splines_built=true;
+
+  // Validate the splines against the analytic forms at the cell
+  // midpoints, where the interpolation error is largest
+  if (verbose>1) {
+    double max_dev=0.0;
+    fit_splines_built=false;
+    for(size_t i=0;i<n_tab-1;i+=16) {
+      double nb=0.5*(fit_nb_tab[i]+fit_nb_tab[i+1]);
+      double dev=fabs(itp_cs2_fit->eval(nb)-cs2_fit(nb))/
+	fabs(cs2_fit(nb));
+      if (dev>max_dev) max_dev=dev;
+    }
+    fit_splines_built=true;
+    cout << "Fit spline max. relative deviation in cs2: "
+	 << max_dev << endl;
+  }
+
+  return;
+}
+
 void eos::min_max_cs2(double &cs2_min, double &cs2_max) {
   double nb=0.08;
   double cs2=cs2_fit(nb);
@@ -368,13 +965,116 @@ void eos::min_max_cs2(double &cs2_min, double &cs2_max) {
   return;
 }
 
+void eos::load_data_tables() {
+
+  if (data_tables_loaded) return;
+
+  // Temporary string for object names
+  string name;
+
+  int mpi_rank=0, mpi_size=1;
+
+#ifdef O2SCL_MPI
+  MPI_Comm_rank(MPI_COMM_WORLD,&mpi_rank);
+  MPI_Comm_size(MPI_COMM_WORLD,&mpi_size);
+
+  // Ensure that multiple MPI ranks aren't reading from the
+  // filesystem at the same time
+  int tag=0, buffer=0;
+  if (mpi_size>1 && mpi_rank>=1) {
+    MPI_Recv(&buffer,1,MPI_INT,mpi_rank-1,
+	     tag,MPI_COMM_WORLD,MPI_STATUS_IGNORE);
+  }
+#endif
+
+  // Open the neutron star data file
+  std::string ns_file="data/qmc_twop_10_0_out";
+  o2scl_hdf::hdf_file hf;
+  hf.open(ns_file);
+  o2scl_hdf::hdf_input(hf,nstar_tab,name);
+  hf.close();
+
+  // Open the Skyrme data file
+  std::string UNEDF_file="data/thetaANL-1002x12.o2";
+  hf.open(UNEDF_file);
+  o2scl_hdf::hdf_input(hf,UNEDF_tab,name);
+  hf.close();
+
+#ifdef O2SCL_MPI
+  // Send a message to the next MPI rank
+  if (mpi_size>1 && mpi_rank<mpi_size-1) {
+    MPI_Send(&buffer,1,MPI_INT,mpi_rank+1,
+	     tag,MPI_COMM_WORLD);
+  }
+#endif
+
+  data_tables_loaded=true;
+  return;
+}
+
+void eos::load_ns_fit_cache() {
+
+  ns_cache_checked=true;
+
+  // Avoid the HDF5 error handler if the cache file is absent
+  std::ifstream test_file("data/ns_fit_cache.o2");
+  if (!test_file.is_open()) return;
+  test_file.close();
+
+  o2scl_hdf::hdf_file hf;
+  hf.open("data/ns_fit_cache.o2");
+  size_t n_rows;
+  hf.get_szt("n_rows",n_rows);
+  hf.getd_vec("parms",ns_cache_parms);
+  hf.getd_vec("chi2",ns_cache_chi2);
+  hf.getd_vec("nb_max",ns_cache_nb_max);
+  hf.close();
+
+  // Sanity check the cache against the neutron star table
+  if (n_rows!=nstar_tab.get_nlines() ||
+      ns_cache_parms.size()!=5*n_rows ||
+      ns_cache_chi2.size()!=n_rows ||
+      ns_cache_nb_max.size()!=n_rows) {
+    cout << "Neutron star fit cache does not match the neutron star "
+	 << "table.\n  Ignoring it." << endl;
+    ns_cache_parms.clear();
+    ns_cache_chi2.clear();
+    ns_cache_nb_max.clear();
+    return;
+  }
+
+  ns_cache_loaded=true;
+  return;
+}
+
 void eos::ns_fit(int row) {
 
+  load_data_tables();
+
   if (row>=((int)(nstar_tab.get_nlines()))) {
     O2SCL_ERR("Row not allowed in ns_fit().",
 	      exc_efailed);
   }
 
+  // If the precomputed fit cache is available, use it instead of
+  // performing the nonlinear fit. The ns_record mode needs the full
+  // fit to write out its table, so it always takes the slow path.
+  if (use_ns_fit_cache && ns_record==false) {
+    if (ns_cache_checked==false) load_ns_fit_cache();
+    if (ns_cache_loaded) {
+      i_ns=row;
+      Lambda_bar_14=nstar_tab.get("lambda_bar14",row);
+      ns_fit_parms.resize(5);
+      for(size_t k=0;k<5;k++) {
+	ns_fit_parms[k]=ns_cache_parms[((size_t)row)*5+k];
+      }
+      chi2_ns=ns_cache_chi2[row];
+      ns_nb_max=ns_cache_nb_max[row];
+      build_fit_splines();
+      return;
+    }
+  }
+
   // Set the class data member to the appropriate row
   i_ns=row;
   
@@ -450,7 +1150,11 @@ void eos::ns_fit(int row) {
   fit_nonlin<chi_fit_funct<std::vector<double>,ubmatrix,fit_funct2>,
 	     std::vector<double>,ubmatrix> fn;
   fn.fit(nparms,ns_fit_parms,covar,chi2_ns,cff);
-  
+
+  // Retabulate the fit functions for the new parameters before
+  // they are used below
+  build_fit_splines();
+
   // Store the results of the fit in column named "EoA_fit", then compute
   // energy density and chemical potential//
   nstar_high.new_column("EoA_fit");
@@ -555,6 +1259,25 @@ eos::eos() {
   select_cs2_test=true;
   a_virial=3.0;
   b_virial=0.0;
+  n_threads=1;
+  table_checkpoint=true;
+  recover_points=true;
+  cs2_numerical=false;
+  use_lepton_table=false;
+  flush_interval=10;
+  use_ns_fit_cache=true;
+  ns_cache_loaded=false;
+  ns_cache_checked=false;
+  use_fit_splines=true;
+  fit_splines_built=false;
+  adapt_tol=0.0;
+  file_compr=0;
+  store_f32=false;
+  fug_warm_start=true;
+  fug_guess_valid=false;
+  fug_zn_guess=0.0;
+  fug_zp_guess=0.0;
+  eos_table_loaded=false;
 
   // Initial parameter values
   i_ns=-1;
@@ -565,8 +1288,9 @@ eos::eos() {
   qmc_b=2.12;
   qmc_n0=0.16;
 
-  // Temporary string for object names
-  string name;
+  // The neutron star and Skyrme data tables are read lazily by
+  // load_data_tables() on the first call from model selection
+  data_tables_loaded=false;
 
   int mpi_rank=0, mpi_size=1;
 
@@ -574,7 +1298,7 @@ eos::eos() {
   // Get MPI rank, etc.
   MPI_Comm_rank(MPI_COMM_WORLD,&mpi_rank);
   MPI_Comm_size(MPI_COMM_WORLD,&mpi_size);
-  
+
   // Ensure that multiple MPI ranks aren't reading from the
   // filesystem at the same time
   int tag=0, buffer=0;
@@ -584,19 +1308,6 @@ eos::eos() {
   }
 #endif
 
-  // Open the neutron star data file
-  std::string ns_file="data/qmc_twop_10_0_out";
-  o2scl_hdf::hdf_file hf;
-  hf.open(ns_file);
-  o2scl_hdf::hdf_input(hf,nstar_tab,name);
-  hf.close();
-
-  // Open the Skyrme data file
-  std::string UNEDF_file="data/thetaANL-1002x12.o2";
-  hf.open(UNEDF_file);
-  o2scl_hdf::hdf_input(hf,UNEDF_tab,name);
-  hf.close();
-
   use_nrapr=false;
 #ifdef O2SCL_CORI
   o2scl_hdf::skyrme_load(sk_nrapr,"data/NRAPR.o2",true,1);
@@ -648,11 +1359,9 @@ double eos::energy_density_ns(double nn) {
   return ed_fit(nn);
 }    
 
-double eos::free_energy_density_virial
-(fermion &n, fermion &p, double T, thermo &th, double &dmundnn,
- double &dmundpn, double &dmupdnn, double &dmupdpn, double &dmundT,
- double &dmupdT) {
- 
+double eos::free_energy_density_virial_base
+(fermion &n, fermion &p, double T, thermo &th) {
+
   double nn=n.n;
   double pn=p.n;
     
@@ -677,9 +1386,38 @@ double eos::free_energy_density_virial
   // virial result
   if (nn*pow(lambda,3.0)>1.0e-5 || pn*pow(lambda,3.0)>1.0e-5) {
     ubvector x(2);
-    acl.solve_fugacity(x);
+    {
+      eos_stats_timer fug_timer(stats,eos_stats::k_fug);
+
+      // Warm start: polish the previous solution by Newton
+      // iteration on the original system, which converges in a
+      // few steps when successive points vary smoothly. Points
+      // where the polish fails use the closed-form quartic
+      // solver as before.
+      bool done=false;
+      if (fug_warm_start && fug_guess_valid) {
+	double nnt=pow(lambda,3.0)/2.0*nn;
+	double npt=pow(lambda,3.0)/2.0*pn;
+	double zng=fug_zn_guess, zpg=fug_zp_guess;
+	if (acl.polish_fugacity(nnt,npt,b_n,b_pn,zng,zpg)) {
+	  acl.zn=zng;
+	  acl.zp=zpg;
+	  x[0]=log(zng)*T;
+	  x[1]=log(zpg)*T;
+	  acl.n_batch_newton++;
+	  done=true;
+	}
+      }
+      if (done==false) {
+	acl.solve_fugacity(x);
+	acl.n_batch_quartic++;
+      }
+    }
     n.mu=x[0];
     p.mu=x[1];
+    fug_zn_guess=acl.zn;
+    fug_zp_guess=acl.zp;
+    fug_guess_valid=true;
   } else {
     // Otherwise, the virial correction is negligable, so
     // just use the classical result
@@ -687,6 +1425,9 @@ double eos::free_energy_density_virial
     p.mu=log(pn*pow(lambda,3.0)/2.0)*T;
     acl.zn=exp(n.mu/T);
     acl.zp=exp(p.mu/T);
+    fug_zn_guess=acl.zn;
+    fug_zp_guess=acl.zp;
+    fug_guess_valid=true;
   }
   double zn=exp(n.mu/T), zp=exp(p.mu/T);
 
@@ -715,26 +1456,49 @@ double eos::free_energy_density_virial
 
   th.ed=f_vir+T*th.en;
 
-  // Use linear solver to obtain derivative of mu_n_vir and
-  // mu_p_vir with respect to neutron number density
-
+  // Store the state required by the derivative solves so that
+  // virial_deriv_mu() can be called afterwards on demand
   acl.mfn2_mu_p=p.mu;
   acl.mfn2_mu_n=n.mu;
-
-  
+  acl.dbndT=dbndT;
+  acl.dbpndT=dbpndT;
+  acl.dlambdadT=dlambdadT;
+
+  if (false && verbose>=2) {
+    cout << "bn= " << b_n << endl;
+    cout << "bpn= " << b_pn << endl;
+  }
+
+  return f_vir;
+}
+
+void eos::virial_deriv_mu
+(double &dmundnn, double &dmundpn, double &dmupdnn, double &dmupdpn,
+ double &dmundT, double &dmupdT) {
+
+  double nn=acl.nn;
+  double pn=acl.pn;
+  double T=acl.T;
+  double lambda=acl.lambda;
+  double zn=acl.zn;
+  double zp=acl.zp;
+
+  // Use linear solver to obtain derivative of mu_n_vir and
+  // mu_p_vir with respect to neutron number density
+
   if (nn*pow(lambda,3.0)>1.0e-5 || pn*pow(lambda,3.0)>1.0e-5){
 
     ubvector x2(2);
     acl.mfn21(x2);
     dmundnn=x2[0];
     dmupdnn=x2[1];
-    
+
   } else {
-  
+
     dmundnn=T*pow(lambda,3.0)/2.0/zn;
     dmupdnn=0;
   }
-	
+
   // Use linear solver to obtain derivative of mu_n_virial and
   // mu_p_virial with respect to proton number density
 
@@ -742,36 +1506,38 @@ double eos::free_energy_density_virial
 
     ubvector x3(2);
     acl.mfn31(x3);
-    dmundpn=x3[0]; 
+    dmundpn=x3[0];
     dmupdpn=x3[1];
 
   } else {
-  
+
     dmupdpn=T*pow(lambda,3.0)/2.0/zp;
     dmundpn=0;
   }
-    	  
+
   // Use linear solver to obtain derivative of mu_n_virial and
   // mu_p_virial with respect to temperature
 
-  acl.dbndT=dbndT;
-  acl.dbpndT=dbpndT;
-  acl.dlambdadT=dlambdadT;
-
   if (nn*pow(lambda,3.0)>1.0e-5 || pn*pow(lambda,3.0)>1.0e-5) {
     ubvector x4(2);
     acl.mfn41(x4);
     dmundT=x4[0];
     dmupdT=x4[1];
   } else {
-    dmundT=n.mu/T-1.5;
-    dmupdT=p.mu/T-1.5;
+    dmundT=acl.mfn2_mu_n/T-1.5;
+    dmupdT=acl.mfn2_mu_p/T-1.5;
   }
-  
-  if (false && verbose>=2) {
-    cout << "bn= " << b_n << endl;
-    cout << "bpn= " << b_pn << endl;
-  } 
+
+  return;
+}
+
+double eos::free_energy_density_virial
+(fermion &n, fermion &p, double T, thermo &th, double &dmundnn,
+ double &dmundpn, double &dmupdnn, double &dmupdpn, double &dmundT,
+ double &dmupdT) {
+
+  double f_vir=free_energy_density_virial_base(n,p,T,th);
+  virial_deriv_mu(dmundnn,dmundpn,dmupdnn,dmupdpn,dmundT,dmupdT);
 
   return f_vir;
 }
@@ -923,6 +1689,8 @@ double eos::free_energy_density
 	      o2scl::exc_einval);
   }
 
+  eos_stats_timer fed_timer(stats,eos_stats::k_fed);
+
   double nn=n.n;
   double pn=p.n;
   double nb=nn+pn;
@@ -1077,39 +1845,83 @@ double eos::free_energy_density
 
     // ----------------------------------------------------------------
     // Next, compute the Skyrme EOS at the specified density, proton
-    // fraction, and temperature
-    
-    n_chiral.n=(nn+pn)/2.0;
-    p_chiral.n=(nn+pn)/2.0;
-    
-    eos_Tcorr->calc_temp_e(n_chiral,p_chiral,T,th_chiral);
-    
-    f_skyrme_eqden_T=th_chiral.ed-T*th_chiral.en; 
-    mu_p_eqden_T=p_chiral.mu;
-    mu_n_eqden_T=n_chiral.mu;
-    s_eqden_T=th_chiral.en;
-    
-    eos_Tcorr->calc_e(n_chiral,p_chiral,th_chiral);
-    
-    f_skyrme_eqden_T0=th_chiral.ed;
-    mu_p_eqden_T0=p_chiral.mu;
-    mu_n_eqden_T0=n_chiral.mu;
-    
-    n_chiral.n=nn+pn;
-    p_chiral.n=0.0;
-    
-    eos_Tcorr->calc_temp_e(n_chiral,p_chiral,T,th_chiral);
-    
-    f_skyrme_neut_T=th_chiral.ed-T*th_chiral.en; 
-    mu_p_neut_T=p_chiral.mu;
-    mu_n_neut_T=n_chiral.mu;
-    s_neut_T=th_chiral.en;
-    
-    eos_Tcorr->calc_e(n_chiral,p_chiral,th_chiral);
-    
-    f_skyrme_neut_T0=th_chiral.ed;
-    mu_p_neut_T0=p_chiral.mu;
-    mu_n_neut_T0=n_chiral.mu;
+    // fraction, and temperature. These four evaluations depend only
+    // on the total baryon density and the temperature, so they are
+    // memoized in sk_cache to avoid recomputing them for every Ye
+    // grid point in table_full().
+
+    double cv[skyrme_Tcorr_cache::nv];
+
+    if (sk_cache.get(nb,T,cv)) {
+
+      f_skyrme_eqden_T=cv[0];
+      mu_p_eqden_T=cv[1];
+      mu_n_eqden_T=cv[2];
+      s_eqden_T=cv[3];
+      f_skyrme_eqden_T0=cv[4];
+      mu_p_eqden_T0=cv[5];
+      mu_n_eqden_T0=cv[6];
+      f_skyrme_neut_T=cv[7];
+      mu_p_neut_T=cv[8];
+      mu_n_neut_T=cv[9];
+      s_neut_T=cv[10];
+      f_skyrme_neut_T0=cv[11];
+      mu_p_neut_T0=cv[12];
+      mu_n_neut_T0=cv[13];
+
+    } else {
+
+      eos_stats_timer sk_timer(stats,eos_stats::k_sk);
+
+      n_chiral.n=(nn+pn)/2.0;
+      p_chiral.n=(nn+pn)/2.0;
+
+      eos_Tcorr->calc_temp_e(n_chiral,p_chiral,T,th_chiral);
+
+      f_skyrme_eqden_T=th_chiral.ed-T*th_chiral.en;
+      mu_p_eqden_T=p_chiral.mu;
+      mu_n_eqden_T=n_chiral.mu;
+      s_eqden_T=th_chiral.en;
+
+      eos_Tcorr->calc_e(n_chiral,p_chiral,th_chiral);
+
+      f_skyrme_eqden_T0=th_chiral.ed;
+      mu_p_eqden_T0=p_chiral.mu;
+      mu_n_eqden_T0=n_chiral.mu;
+
+      n_chiral.n=nn+pn;
+      p_chiral.n=0.0;
+
+      eos_Tcorr->calc_temp_e(n_chiral,p_chiral,T,th_chiral);
+
+      f_skyrme_neut_T=th_chiral.ed-T*th_chiral.en;
+      mu_p_neut_T=p_chiral.mu;
+      mu_n_neut_T=n_chiral.mu;
+      s_neut_T=th_chiral.en;
+
+      eos_Tcorr->calc_e(n_chiral,p_chiral,th_chiral);
+
+      f_skyrme_neut_T0=th_chiral.ed;
+      mu_p_neut_T0=p_chiral.mu;
+      mu_n_neut_T0=n_chiral.mu;
+
+      cv[0]=f_skyrme_eqden_T;
+      cv[1]=mu_p_eqden_T;
+      cv[2]=mu_n_eqden_T;
+      cv[3]=s_eqden_T;
+      cv[4]=f_skyrme_eqden_T0;
+      cv[5]=mu_p_eqden_T0;
+      cv[6]=mu_n_eqden_T0;
+      cv[7]=f_skyrme_neut_T;
+      cv[8]=mu_p_neut_T;
+      cv[9]=mu_n_neut_T;
+      cv[10]=s_neut_T;
+      cv[11]=f_skyrme_neut_T0;
+      cv[12]=mu_p_neut_T0;
+      cv[13]=mu_n_neut_T0;
+      sk_cache.store(nb,T,cv);
+
+    }
 
   }
   
@@ -1366,13 +2178,39 @@ double eos::free_energy_density_alt
   return free_energy_density(n,p,T,th);
 }
 
+void eos::compute_electron(double ne, double T) {
+
+  eos_stats_timer elec_timer(stats,eos_stats::k_elec);
+
+  if (use_lepton_table) {
+    if (lep_tab.built==false) {
+      lep_tab.build(electron,relf);
+      cout << "Lepton table maximum relative deviation: "
+	   << lep_tab.max_dev(electron,relf) << endl;
+    }
+    double edl, prl, enl, muel;
+    if (lep_tab.get(ne,T,edl,prl,enl,muel)) {
+      electron.n=ne;
+      electron.mu=muel;
+      electron.ed=edl;
+      electron.pr=prl;
+      electron.en=enl;
+      return;
+    }
+  }
+
+  electron.n=ne;
+  electron.mu=electron.m;
+  relf.pair_density(electron,T);
+
+  return;
+}
+
 double eos::free_energy_density_ep
 (double nn, double np, double T) {
   neutron.n=nn;
   proton.n=np;
-  electron.n=np;
-  electron.mu=electron.m;
-  relf.pair_density(electron,T);
+  compute_electron(np,T);
   photon.massless_calc(T);
   double frnp;
   if (use_nrapr) {
@@ -1399,9 +2237,7 @@ double eos::entropy(fermion &n, fermion &p, double nn,
   } else {
     free_energy_density(n,p,T,th);
   }
-  electron.n=pn;
-  electron.mu=electron.m;
-  relf.pair_density(electron,T);
+  compute_electron(pn,T);
   photon.massless_calc(T);
   return th.en+electron.en+photon.en;
 }
@@ -1417,9 +2253,7 @@ double eos::ed(fermion &n, fermion &p, double nn,
   } else {
     free_energy_density(n,p,T,th);
   }
-  electron.n=pn;
-  electron.mu=electron.m;
-  relf.pair_density(electron,T);
+  compute_electron(pn,T);
   photon.massless_calc(T);
   return th.ed+electron.ed+photon.ed+n.m*nn+p.m*pn;
 }
@@ -1436,9 +2270,7 @@ double eos::dfdnn_total(fermion &n, fermion &p, double nn,
   } else {
     free_energy_density(n,p,T,th);
   }
-  electron.n=pn;
-  electron.mu=electron.m;
-  relf.pair_density(electron,T);
+  compute_electron(pn,T);
   return n.mu+n.m;
 }
 
@@ -1454,14 +2286,112 @@ double eos::dfdpn_total(fermion &n, fermion &p, double nn,
   } else {
     free_energy_density(n,p,T,th);
   }
-  electron.n=pn;
-  electron.mu=electron.m;
-  relf.pair_density(electron,T);
+  compute_electron(pn,T);
   return p.mu+electron.mu+p.m;
 }
 
+void eos::mu_s_total(fermion &n, fermion &p, double nn, double pn,
+		     double T, thermo &th, double &mun_tot,
+		     double &mup_tot, double &s_tot, double &ed_tot) {
+
+  n.n=nn;
+  p.n=pn;
+  n.mu=n.m;
+  p.mu=p.m;
+  if (use_nrapr) {
+    sk_nrapr.calc_temp_e(n,p,T,th);
+  } else {
+    free_energy_density(n,p,T,th);
+  }
+  compute_electron(pn,T);
+  photon.massless_calc(T);
+
+  mun_tot=n.mu+n.m;
+  mup_tot=p.mu+electron.mu+p.m;
+  s_tot=th.en+electron.en+photon.en;
+  ed_tot=th.ed+electron.ed+photon.ed+n.m*nn+p.m*pn;
+
+  return;
+}
+
 double eos::cs2_fixYe(fermion &n, fermion &p, double T, thermo &th) {
- 
+
+  eos_stats_timer cs2_timer(stats,eos_stats::k_cs2);
+
+  if (cs2_numerical) {
+    return cs2_fixYe_numerical(n,p,T,th);
+  }
+
+  double nn=n.n;
+  double pn=p.n;
+  double nb=nn+pn;
+  double ne=pn;
+
+  // Step sizes for the fixed central-difference stencil
+  double hn=nn*1.0e-4;
+  double hp=pn*1.0e-4;
+  double hT=T*1.0e-4;
+
+  // The center point, which provides the first derivatives, the
+  // entropy, and the energy density
+  double mub, mupt, s, ed1;
+  mu_s_total(n,p,nn,pn,T,th,mub,mupt,s,ed1);
+  double mul=mupt-mub;
+
+  // The six offset points, which provide the nine second
+  // derivatives
+  double mun_p, mup_p, s_p, mun_m, mup_m, s_m, ed_x;
+
+  mu_s_total(n,p,nn+hn,pn,T,th,mun_p,mup_p,s_p,ed_x);
+  mu_s_total(n,p,nn-hn,pn,T,th,mun_m,mup_m,s_m,ed_x);
+  double dfdnn_totaldnn=(mun_p-mun_m)/2.0/hn;
+  double dfdpn_totaldnn=(mup_p-mup_m)/2.0/hn;
+  double dsdnn=(s_p-s_m)/2.0/hn;
+
+  mu_s_total(n,p,nn,pn+hp,T,th,mun_p,mup_p,s_p,ed_x);
+  mu_s_total(n,p,nn,pn-hp,T,th,mun_m,mup_m,s_m,ed_x);
+  double dfdnn_totaldpn=(mun_p-mun_m)/2.0/hp;
+  double dfdpn_totaldpn=(mup_p-mup_m)/2.0/hp;
+  double dsdpn=(s_p-s_m)/2.0/hp;
+
+  mu_s_total(n,p,nn,pn,T+hT,th,mun_p,mup_p,s_p,ed_x);
+  mu_s_total(n,p,nn,pn,T-hT,th,mun_m,mup_m,s_m,ed_x);
+  double dfdnn_totaldT=(mun_p-mun_m)/2.0/hT;
+  double dfdpn_totaldT=(mup_p-mup_m)/2.0/hT;
+  double dsdT=(s_p-s_m)/2.0/hT;
+
+  double dfdnbdT, dfdnedT, dfdnbdne, dfdTdT, dfdnbdnb, dfdnedne;
+  dfdnbdT=dfdnn_totaldT;
+  dfdnedT=dfdpn_totaldT-dfdnn_totaldT;
+  dfdnbdne=dfdnn_totaldpn-dfdnn_totaldnn;
+  dfdTdT=-dsdT;
+  dfdnbdnb=dfdnn_totaldnn;
+  dfdnedne=dfdpn_totaldpn+dfdnn_totaldnn-dfdpn_totaldnn-dfdnn_totaldpn;
+
+  // Compute dPdNb
+  double dPdnb=dfdnbdnb*nb+dfdnbdne*ne;
+
+  // Compute dPdNe
+  double dPdne=dfdnbdne*nb+dfdnedne*ne;
+
+  // Compute dPdT
+  double dPdT=dfdnbdT*nb+dfdnedT*ne+s;
+
+  double pr=mul*ne+mub*nb+T*s-ed1;
+
+  double cs_sq=(-nb*dPdnb*dfdTdT-ne*dPdne*dfdTdT+dPdT*
+		(dfdnbdT*nb+dfdnedT*ne+s))/((pr+ed1)*(-dfdTdT));
+
+  // Restore the densities at the specified point
+  n.n=nn;
+  p.n=pn;
+
+  return cs_sq;
+}
+
+double eos::cs2_fixYe_numerical(fermion &n, fermion &p, double T,
+				thermo &th) {
+
   double nn,pn;
   deriv_gsl<> gd;
   nn=n.n;
@@ -1965,35 +2895,568 @@ int eos::table_nB(std::vector<std::string> &sv, bool itive_com) {
   return 0;
 }
 
-int eos::table_full(std::vector<std::string> &sv, bool itive_com) {
+int eos::table_full_point(double nB, double Ye, double T_MeV,
+			  eos_sn_oo &eso, double *res) {
 
-  std::string fname=sv[1];
+  eos_stats_timer point_timer(stats,eos_stats::k_point);
+
+  int ret=table_full_point_attempt(nB,Ye,T_MeV,eso,res);
+
+  if (ret!=0) {
+
+    // First retry: perturb the densities slightly, which moves
+    // the initial guesses of the internal solvers off the failing
+    // trajectory
+    cout << "Retrying with perturbed densities." << endl;
+    ret=table_full_point_attempt(nB*(1.0+1.0e-6),Ye,T_MeV,eso,res);
+
+    if (ret!=0) {
+      // Second retry: tighten the Skyrme density-solver
+      // tolerances, restoring them afterwards
+      cout << "Retrying with tightened tolerances." << endl;
+      double tol_rel_old=sk_Tcorr.nrf.def_density_root.tol_rel;
+      double tol_abs_old=sk_Tcorr.nrf.def_density_root.tol_abs;
+      sk_Tcorr.nrf.def_density_root.tol_rel/=1.0e2;
+      sk_Tcorr.nrf.def_density_root.tol_abs/=1.0e2;
+      ret=table_full_point_attempt(nB,Ye,T_MeV,eso,res);
+      sk_Tcorr.nrf.def_density_root.tol_rel=tol_rel_old;
+      sk_Tcorr.nrf.def_density_root.tol_abs=tol_abs_old;
+    }
+
+    if (ret!=0) {
+      // Mark the cell for the interpolation post-pass in
+      // table_full()
+      cout << "Point failed after retries, marking for "
+	   << "interpolation." << endl;
+      for(size_t q=0;q<12;q++) {
+	res[q]=std::numeric_limits<double>::quiet_NaN();
+      }
+    } else {
+      cout << "Point recovered." << endl;
+    }
+  }
+
+  return ret;
+}
+
+int eos::table_full_point_attempt(double nB, double Ye, double T_MeV,
+				  eos_sn_oo &eso, double *res) {
+
+  // Hadronic part
+  neutron.n=nB*(1.0-Ye);
+  proton.n=nB*Ye;
+  if (use_nrapr) {
+    sk_nrapr.calc_temp_e(neutron,proton,T_MeV/hc_mev_fm,th2);
+  } else {
+    free_energy_density(neutron,proton,T_MeV/hc_mev_fm,th2);
+  }
+
+  thermo lep;
+  if (use_lepton_table && include_muons==false) {
+    // The table covers the electrons and positrons; the photon
+    // part is analytic
+    compute_electron(nB*Ye,T_MeV/hc_mev_fm);
+    photon.massless_calc(T_MeV/hc_mev_fm);
+    lep.ed=electron.ed+photon.ed;
+    lep.pr=electron.pr+photon.pr;
+    lep.en=electron.en+photon.en;
+    eso.electron.mu=electron.mu;
+  } else {
+    eso.compute_eg_point(nB,Ye,T_MeV,lep);
+  }
+
+  res[0]=hc_mev_fm*(th2.ed-T_MeV/hc_mev_fm*th2.en)/
+    (neutron.n+proton.n);
+  res[1]=hc_mev_fm*(th2.ed+lep.ed-T_MeV/hc_mev_fm*th2.en)/
+    (neutron.n+proton.n);
+  res[2]=hc_mev_fm*(th2.ed)/(neutron.n+proton.n);
+  res[3]=hc_mev_fm*(th2.ed+lep.ed)/(neutron.n+proton.n);
+  res[4]=hc_mev_fm*(th2.pr);
+  res[5]=hc_mev_fm*(th2.pr+lep.pr);
+  res[6]=hc_mev_fm*(th2.en)/(neutron.n+proton.n);
+  res[7]=hc_mev_fm*(th2.en+lep.en)/(neutron.n+proton.n);
+  res[8]=hc_mev_fm*neutron.mu;
+  res[9]=hc_mev_fm*proton.mu;
+  res[10]=cs2_fixYe(neutron,proton,T_MeV/hc_mev_fm,th2);
+  res[11]=eso.electron.mu;
+
+  if (!std::isfinite(th2.ed)) {
+    cout << "Hadronic energy density not finite." << endl;
+    cout << "n_B: " << nB << " Y_e: " << Ye << " T: "
+	 << T_MeV << endl;
+    cout << "hadrons ed: " << th2.ed << " pr: " << th2.pr
+	 << " en: " << th2.en << endl;
+    if (recover_points) return 1;
+    exit(-1);
+  }
+  if (!std::isfinite(th2.pr)) {
+    cout << "Hadronic pressure not finite." << endl;
+    cout << "n_B: " << nB << " Y_e: " << Ye << " T: "
+	 << T_MeV << endl;
+    cout << "hadrons ed: " << th2.ed << " pr: " << th2.pr
+	 << " en: " << th2.en << endl;
+    if (recover_points) return 1;
+    exit(-1);
+  }
+  if (!std::isfinite(th2.en)) {
+    cout << "Hadronic entropy density not finite." << endl;
+    cout << "n_B: " << nB << " Y_e: " << Ye << " T: "
+	 << T_MeV << endl;
+    cout << "hadrons ed: " << th2.ed << " pr: " << th2.pr
+	 << " en: " << th2.en << endl;
+    if (recover_points) return 1;
+    exit(-1);
+  }
+  if (!std::isfinite(lep.ed)) {
+    cout << "Leptonic energy density not finite." << endl;
+    cout << "n_B: " << nB << " Y_e: " << Ye << " T: "
+	 << T_MeV << endl;
+    cout << "leptons ed: " << lep.ed << " pr: " << lep.pr
+	 << " en: " << lep.en << endl;
+    if (recover_points) return 1;
+    exit(-1);
+  }
+  if (!std::isfinite(lep.pr)) {
+    cout << "Leptonic pressure not finite." << endl;
+    cout << "n_B: " << nB << " Y_e: " << Ye << " T: "
+	 << T_MeV << endl;
+    cout << "leptons ed: " << lep.ed << " pr: " << lep.pr
+	 << " en: " << lep.en << endl;
+    if (recover_points) return 1;
+    exit(-1);
+  }
+  if (!std::isfinite(lep.en)) {
+    cout << "Leptonic entropy density not finite." << endl;
+    cout << "n_B: " << nB << " Y_e: " << Ye << " T: "
+	 << T_MeV << endl;
+    cout << "leptons ed: " << lep.ed << " pr: " << lep.pr
+	 << " en: " << lep.en << endl;
+    if (recover_points) return 1;
+    exit(-1);
+  }
+  if (th2.en+lep.en<0.0 && th2.pr>0.0) {
+    cout << "Entropy negative where pressure is positive." << endl;
+    cout << "n_B: " << nB << " Y_e: " << Ye << " T: "
+	 << T_MeV << endl;
+    cout << "hadrons ed: " << th2.ed << " pr: " << th2.pr
+	 << " en: " << th2.en << endl;
+    cout << "leptons ed: " << lep.ed << " pr: " << lep.pr
+	 << " en: " << lep.en << endl;
+    if (recover_points) return 1;
+    exit(-1);
+  }
+
+  return 0;
+}
+
+void eos::make_workers(std::vector<std::shared_ptr<eos> > &workers,
+		       size_t n) {
+
+  // Load the shared data tables on the parent first so the worker
+  // copies inherit them. Otherwise the first threaded evaluations
+  // would race to open the same HDF5 files, and serial HDF5 is
+  // not thread-safe.
+  load_data_tables();
+
+  // The same applies to the neutron star fit cache, which the
+  // workers would otherwise all read on their first ns_fit() call
+  if (use_ns_fit_cache && ns_cache_checked==false) {
+    load_ns_fit_cache();
+  }
+
+  workers.clear();
+  for(size_t it=0;it<n;it++) {
+    std::shared_ptr<eos> w(new eos(*this));
+    // The copy constructor leaves eos_Tcorr pointing at the
+    // original object, so redirect it to the worker's own copy
+    w->eos_Tcorr=&(w->sk_Tcorr);
+    workers.push_back(w);
+  }
+  return;
+}
+
+void eos::table_full_slab(size_t i, const std::vector<double> &nB_grid,
+			  const std::vector<double> &Ye_grid,
+			  const std::vector<double> &T_grid,
+			  std::vector<std::shared_ptr<eos> > &workers,
+			  std::vector<double> &slab) {
+
+  size_t n_Ye=Ye_grid.size();
+  size_t n_T=T_grid.size();
+  slab.resize(12*n_Ye*n_T);
+
+  if (workers.size()<2) {
+
+    // Serial evaluation
+    eos_sn_oo eso;
+    eso.include_muons=include_muons;
+    double res[12];
+    for(size_t j=0;j<n_Ye;j++) {
+      for(size_t k=0;k<n_T;k++) {
+	table_full_point(nB_grid[i],Ye_grid[j],T_grid[k],eso,res);
+	for(size_t q=0;q<12;q++) {
+	  slab[(j*n_T+k)*12+q]=res[q];
+	}
+      }
+    }
+
+  } else {
+
+    // Distribute the Ye loop over the workers, each of which has
+    // its own copies of the evaluation state
+    size_t nth=workers.size();
+    std::vector<std::thread> th_arr;
+    for(size_t it=0;it<nth;it++) {
+      eos *w=workers[it].get();
+      th_arr.push_back(std::thread
+		       ([w,it,nth,i,n_Ye,n_T,&nB_grid,&Ye_grid,
+			 &T_grid,&slab]() {
+			 eos_sn_oo eso;
+			 eso.include_muons=w->include_muons;
+			 double res[12];
+			 for(size_t j=it;j<n_Ye;j+=nth) {
+			   for(size_t k=0;k<n_T;k++) {
+			     w->table_full_point(nB_grid[i],Ye_grid[j],
+						 T_grid[k],eso,res);
+			     for(size_t q=0;q<12;q++) {
+			       slab[(j*n_T+k)*12+q]=res[q];
+			     }
+			   }
+			 }
+		       }));
+    }
+    for(size_t it=0;it<nth;it++) {
+      th_arr[it].join();
+    }
+
+  }
+
+  return;
+}
+
+void eos::tensor_out_f32(o2scl_hdf::hdf_file &hf, tensor_grid3<> &t,
+			 std::string name) {
+  size_t n0=t.get_size(0);
+  size_t n1=t.get_size(1);
+  size_t n2=t.get_size(2);
+  std::vector<float> fdat(n0*n1*n2);
+  for(size_t i=0;i<n0;i++) {
+    for(size_t j=0;j<n1;j++) {
+      for(size_t k=0;k<n2;k++) {
+	fdat[(i*n1+j)*n2+k]=((float)t.get(i,j,k));
+      }
+    }
+  }
+  hf.setf_vec(name,fdat);
+  return;
+}
+
+int eos::table_full_adaptive(std::string fname) {
 
   size_t n_nB=301;
   size_t n_Ye=99;
   size_t n_T=160;
-    
+
   std::string nB_grid_spec="10^(i*0.04-12)*2.0";
   std::string Ye_grid_spec="0.01*(i+1)";
   std::string T_grid_spec="0.2+0.81*i";
 
   vector<double> nB_grid, T_grid, Ye_grid;
-  
+
   calculator calc;
   std::map<std::string,double> vars;
-  
+
   calc.compile(nB_grid_spec.c_str());
   for(size_t i=0;i<n_nB;i++) {
     vars["i"]=((double)i);
     nB_grid.push_back(calc.eval(&vars));
   }
-  
+
   calc.compile(Ye_grid_spec.c_str());
   for(size_t i=0;i<n_Ye;i++) {
     vars["i"]=((double)i);
     Ye_grid.push_back(calc.eval(&vars));
   }
-  
+
+  calc.compile(T_grid_spec.c_str());
+  for(size_t i=0;i<n_T;i++) {
+    vars["i"]=((double)i);
+    T_grid.push_back(calc.eval(&vars));
+  }
+
+  vector<vector<double> > grid_arr={nB_grid,Ye_grid,T_grid};
+
+  // The twelve quantities in the table_full_point() order
+  static const char *qnames[12]={"Fint","F","Eint","E","Pint","P",
+				 "Sint","S","mun","mup","cs2","mue"};
+  std::vector<tensor_grid3<> > tens(12);
+  for(size_t q=0;q<12;q++) {
+    tens[q].resize(n_nB,n_Ye,n_T);
+    tens[q].set_grid(grid_arr);
+  }
+
+  // Precompute the virial coefficients on the temperature grid
+  ecv.set_T_grid(T_grid);
+
+  if (use_lepton_table && lep_tab.built==false) {
+    lep_tab.build(electron,relf);
+    cout << "Lepton table maximum relative deviation: "
+	 << lep_tab.max_dev(electron,relf) << endl;
+  }
+
+  eos_sn_oo eso;
+  double res[12];
+
+  // Flags marking grid points which have been either evaluated
+  // or filled by interpolation
+  std::vector<char> have(n_nB*n_Ye*n_T,0);
+  size_t n_eval=0, n_interp=0;
+
+  auto eval_pt=[&](size_t i, size_t j, size_t k) {
+    table_full_point(nB_grid[i],Ye_grid[j],T_grid[k],eso,res);
+    for(size_t q=0;q<12;q++) {
+      tens[q].set(i,j,k,res[q]);
+    }
+    have[(i*n_Ye+j)*n_T+k]=1;
+    n_eval++;
+    return;
+  };
+
+  // The coarse sub-grid: every fourth index plus the last one
+  auto coarse_list=[](size_t n) {
+    std::vector<size_t> v;
+    for(size_t i=0;i<n;i+=4) v.push_back(i);
+    if (v[v.size()-1]!=n-1) v.push_back(n-1);
+    return v;
+  };
+  std::vector<size_t> ci=coarse_list(n_nB);
+  std::vector<size_t> cj=coarse_list(n_Ye);
+  std::vector<size_t> ck=coarse_list(n_T);
+
+  // ----------------------------------------------------------------
+  // Coarse pass
+
+  for(size_t a=0;a<ci.size();a++) {
+    for(size_t b=0;b<cj.size();b++) {
+      for(size_t c=0;c<ck.size();c++) {
+	eval_pt(ci[a],cj[b],ck[c]);
+      }
+    }
+    cout << "Adaptive coarse pass: " << a+1 << " of " << ci.size()
+	 << " nB planes." << endl;
+  }
+
+  // Interpolation weights within a cell. The baryon density grid
+  // is logarithmic, so its weight is computed in log10(nB).
+  auto cell_wgt=[&](size_t i0, size_t i1, size_t j0, size_t j1,
+		    size_t k0, size_t k1, size_t i, size_t j,
+		    size_t k, double *w) {
+    w[0]=(log10(nB_grid[i])-log10(nB_grid[i0]))/
+      (log10(nB_grid[i1])-log10(nB_grid[i0]));
+    w[1]=(Ye_grid[j]-Ye_grid[j0])/(Ye_grid[j1]-Ye_grid[j0]);
+    w[2]=(T_grid[k]-T_grid[k0])/(T_grid[k1]-T_grid[k0]);
+    return;
+  };
+
+  auto trilin=[&](size_t q, size_t i0, size_t i1, size_t j0,
+		  size_t j1, size_t k0, size_t k1,
+		  const double *w) {
+    double v=0.0;
+    for(size_t di=0;di<2;di++) {
+      for(size_t dj=0;dj<2;dj++) {
+	for(size_t dk=0;dk<2;dk++) {
+	  v+=(di==0?1.0-w[0]:w[0])*(dj==0?1.0-w[1]:w[1])*
+	    (dk==0?1.0-w[2]:w[2])*
+	    tens[q].get(di==0?i0:i1,dj==0?j0:j1,dk==0?k0:k1);
+	}
+      }
+    }
+    return v;
+  };
+
+  // ----------------------------------------------------------------
+  // Refinement pass over the coarse cells
+
+  size_t n_refined=0, n_cells=0;
+
+  for(size_t a=0;a<ci.size()-1;a++) {
+    for(size_t b=0;b<cj.size()-1;b++) {
+      for(size_t c=0;c<ck.size()-1;c++) {
+
+	size_t i0=ci[a], i1=ci[a+1];
+	size_t j0=cj[b], j1=cj[b+1];
+	size_t k0=ck[c], k1=ck[c+1];
+	n_cells++;
+
+	// Cells with no interior points are already complete
+	if (i1-i0<2 && j1-j0<2 && k1-k0<2) continue;
+
+	// Estimate the interpolation error at the cell midpoint
+	size_t im=(i0+i1)/2, jm=(j0+j1)/2, km=(k0+k1)/2;
+	double w[3];
+	cell_wgt(i0,i1,j0,j1,k0,k1,im,jm,km,w);
+	double F_int=trilin(1,i0,i1,j0,j1,k0,k1,w);
+	double cs2_int=trilin(10,i0,i1,j0,j1,k0,k1,w);
+	if (have[(im*n_Ye+jm)*n_T+km]==0) eval_pt(im,jm,km);
+	double F_true=tens[1].get(im,jm,km);
+	double cs2_true=tens[10].get(im,jm,km);
+
+	// Free energies are in MeV, so the error is relative to
+	// a MeV scale; cs2 is compared absolutely
+	double err=fabs(F_int-F_true)/(fabs(F_true)+1.0);
+	double err2=fabs(cs2_int-cs2_true);
+	if (err2>err) err=err2;
+
+	// Refine on a poor error estimate, and also whenever any
+	// of the values involved is non-finite, so that failed
+	// corner points are never interpolated into a whole cell
+	bool refine=(err>adapt_tol);
+	if (!std::isfinite(F_int) || !std::isfinite(F_true) ||
+	    !std::isfinite(cs2_int) || !std::isfinite(cs2_true)) {
+	  refine=true;
+	}
+
+	for(size_t i=i0;i<=i1;i++) {
+	  for(size_t j=j0;j<=j1;j++) {
+	    for(size_t k=k0;k<=k1;k++) {
+	      if (have[(i*n_Ye+j)*n_T+k]!=0) continue;
+	      if (refine) {
+		eval_pt(i,j,k);
+	      } else {
+		cell_wgt(i0,i1,j0,j1,k0,k1,i,j,k,w);
+		for(size_t q=0;q<12;q++) {
+		  tens[q].set(i,j,k,trilin(q,i0,i1,j0,j1,k0,k1,w));
+		}
+		have[(i*n_Ye+j)*n_T+k]=1;
+		n_interp++;
+	      }
+	    }
+	  }
+	}
+	if (refine) n_refined++;
+
+      }
+    }
+    cout << "Adaptive refinement: " << a+1 << " of " << ci.size()-1
+	 << " nB planes, " << n_eval << " evaluated, "
+	 << n_interp << " interpolated." << endl;
+  }
+
+  cout << "Adaptive table: " << n_refined << " of " << n_cells
+       << " cells refined, " << n_eval << " points evaluated, "
+       << n_interp << " interpolated ("
+       << ((double)n_eval)/((double)(n_nB*n_Ye*n_T))*100.0
+       << " percent evaluated)." << endl;
+
+  // ----------------------------------------------------------------
+  // Fill any remaining non-finite cells from failed points along
+  // the temperature direction, as in the standard mode
+
+  std::vector<double> fail_nB, fail_Ye, fail_T;
+  for(size_t i=0;i<n_nB;i++) {
+    for(size_t j=0;j<n_Ye;j++) {
+      for(size_t k=0;k<n_T;k++) {
+	if (!std::isfinite(tens[1].get(i,j,k))) {
+	  fail_nB.push_back(nB_grid[i]);
+	  fail_Ye.push_back(Ye_grid[j]);
+	  fail_T.push_back(T_grid[k]);
+	  int klo=((int)k)-1;
+	  while (klo>=0 && !std::isfinite(tens[1].get(i,j,klo))) klo--;
+	  size_t khi=k+1;
+	  while (khi<n_T && !std::isfinite(tens[1].get(i,j,khi))) khi++;
+	  for(size_t q=0;q<12;q++) {
+	    if (klo>=0 && khi<n_T) {
+	      double vlo=tens[q].get(i,j,klo);
+	      double vhi=tens[q].get(i,j,khi);
+	      tens[q].set(i,j,k,vlo+(vhi-vlo)*(T_grid[k]-T_grid[klo])/
+			  (T_grid[khi]-T_grid[klo]));
+	    } else if (klo>=0) {
+	      tens[q].set(i,j,k,tens[q].get(i,j,klo));
+	    } else if (khi<n_T) {
+	      tens[q].set(i,j,k,tens[q].get(i,j,khi));
+	    }
+	  }
+	}
+      }
+    }
+  }
+  if (fail_nB.size()>0) {
+    cout << "Interpolated " << fail_nB.size()
+	 << " failed points." << endl;
+  }
+
+  hdf_file hf;
+  hf.open_or_create(fname);
+  hf.compr_type=file_compr;
+  hf.set_szt("n_nB",n_nB);
+  hf.set_szt("n_Ye",n_Ye);
+  hf.set_szt("n_T",n_T);
+  hf.setd_vec("nB_grid",nB_grid);
+  hf.setd_vec("Ye_grid",Ye_grid);
+  hf.setd_vec("T_grid",T_grid);
+  for(size_t q=0;q<12;q++) {
+    if (store_f32 && (q==10 || q==11)) {
+      tensor_out_f32(hf,tens[q],qnames[q]);
+    } else {
+      hdf_output(hf,tens[q],qnames[q]);
+    }
+  }
+  hf.set_szt("f32_data",store_f32 ? 1 : 0);
+  hf.setd("adapt_tol",adapt_tol);
+  hf.set_szt("n_eval",n_eval);
+  hf.set_szt("n_fail",fail_nB.size());
+  if (fail_nB.size()>0) {
+    hf.setd_vec("fail_nB",fail_nB);
+    hf.setd_vec("fail_Ye",fail_Ye);
+    hf.setd_vec("fail_T",fail_T);
+  }
+  if (stats.enabled) {
+    stats.hdf_out(hf);
+  }
+  hf.close();
+
+  if (stats.enabled) {
+    stats.report();
+  }
+
+  return 0;
+}
+
+int eos::table_full(std::vector<std::string> &sv, bool itive_com) {
+
+  std::string fname=sv[1];
+
+  // Adaptive mode refines only the coarse cells above the error
+  // tolerance and fills the rest by interpolation
+  if (adapt_tol>0.0) {
+    return table_full_adaptive(fname);
+  }
+
+  size_t n_nB=301;
+  size_t n_Ye=99;
+  size_t n_T=160;
+    
+  std::string nB_grid_spec="10^(i*0.04-12)*2.0";
+  std::string Ye_grid_spec="0.01*(i+1)";
+  std::string T_grid_spec="0.2+0.81*i";
+
+  vector<double> nB_grid, T_grid, Ye_grid;
+  
+  calculator calc;
+  std::map<std::string,double> vars;
+  
+  calc.compile(nB_grid_spec.c_str());
+  for(size_t i=0;i<n_nB;i++) {
+    vars["i"]=((double)i);
+    nB_grid.push_back(calc.eval(&vars));
+  }
+  
+  calc.compile(Ye_grid_spec.c_str());
+  for(size_t i=0;i<n_Ye;i++) {
+    vars["i"]=((double)i);
+    Ye_grid.push_back(calc.eval(&vars));
+  }
+  
   calc.compile(T_grid_spec.c_str());
   for(size_t i=0;i<n_T;i++) {
     vars["i"]=((double)i);
@@ -2003,6 +3466,10 @@ int eos::table_full(std::vector<std::string> &sv, bool itive_com) {
   size_t size_arr[3]={n_nB,n_Ye,n_T};
   vector<vector<double> > grid_arr={nB_grid,Ye_grid,T_grid};
 
+  // All twelve tensors stay resident for the full run because
+  // hdf_output() only writes complete tensor_grid objects, so the
+  // finished slabs cannot be streamed to disk as they complete (see
+  // the table_full() documentation in eos.h)
   tensor_grid3<> t_F(n_nB,n_Ye,n_T);
   t_F.set_grid(grid_arr);
   tensor_grid3<> t_Fint(n_nB,n_Ye,n_T);
@@ -2028,109 +3495,300 @@ int eos::table_full(std::vector<std::string> &sv, bool itive_com) {
   tensor_grid3<> t_mue(n_nB,n_Ye,n_T);
   t_mue.set_grid(grid_arr);
 
-  eos_sn_oo eso;
-  eso.include_muons=include_muons;
-  
-  for(int i=n_nB-1;i>=0;i--) {
-    cout << "i_nB,n_nB,nB[i]: " << n_nB-1-i << " " << n_nB << " "
-	 << nB_grid[i] << endl;
+  // Precompute the virial coefficients on the temperature grid
+  ecv.set_T_grid(T_grid);
+
+  // Build the lepton table up front so the worker objects copy
+  // it instead of racing to build their own
+  if (use_lepton_table && lep_tab.built==false) {
+    lep_tab.build(electron,relf);
+    cout << "Lepton table maximum relative deviation: "
+	 << lep_tab.max_dev(electron,relf) << endl;
+  }
+
+  // Create the worker objects if a threaded evaluation was
+  // requested
+  std::vector<std::shared_ptr<eos> > workers;
+  if (n_threads>1) {
+    size_t nth=n_threads;
+    if (nth>n_Ye) nth=n_Ye;
+    make_workers(workers,nth);
+  }
+
+  std::vector<double> slab;
+  size_t slab_size=12*n_Ye*n_T;
+
+  // Convert one point-major slab to the twelve per-quantity
+  // tensor objects. This conversion only happens once per slab,
+  // at checkpoint/write time, so the evaluation loop itself only
+  // touches the fused layout.
+  auto store_slab=[&](size_t i, const std::vector<double> &sl) {
     for(size_t j=0;j<n_Ye;j++) {
       for(size_t k=0;k<n_T;k++) {
+	const double *pt=&sl[(j*n_T+k)*12];
+	t_Fint.set(i,j,k,pt[0]);
+	t_F.set(i,j,k,pt[1]);
+	t_Eint.set(i,j,k,pt[2]);
+	t_E.set(i,j,k,pt[3]);
+	t_Pint.set(i,j,k,pt[4]);
+	t_P.set(i,j,k,pt[5]);
+	t_Sint.set(i,j,k,pt[6]);
+	t_S.set(i,j,k,pt[7]);
+	t_mun.set(i,j,k,pt[8]);
+	t_mup.set(i,j,k,pt[9]);
+	t_cs2.set(i,j,k,pt[10]);
+	t_mue.set(i,j,k,pt[11]);
+      }
+    }
+  };
 
-	// Hadronic part
-	neutron.n=nB_grid[i]*(1.0-Ye_grid[j]);
-	proton.n=nB_grid[i]*Ye_grid[j];
-	if (use_nrapr) {
-	  sk_nrapr.calc_temp_e(neutron,proton,T_grid[k]/hc_mev_fm,th2);
-	} else {
-	  free_energy_density(neutron,proton,T_grid[k]/hc_mev_fm,th2);
-	}
+  // If true, the nB slabs have already been computed by the MPI
+  // work queue below
+  bool slabs_done=false;
 
-	thermo lep;
-	eso.compute_eg_point(nB_grid[i],Ye_grid[j],T_grid[k],lep);
-	
-	t_Fint.set(i,j,k,hc_mev_fm*(th2.ed-T_grid[k]/hc_mev_fm*th2.en)/
-		   (neutron.n+proton.n));
-	t_F.set(i,j,k,hc_mev_fm*(th2.ed+lep.ed-T_grid[k]/hc_mev_fm*th2.en)/
-		(neutron.n+proton.n));
-	t_Eint.set(i,j,k,hc_mev_fm*(th2.ed)/(neutron.n+proton.n));
-	t_E.set(i,j,k,hc_mev_fm*(th2.ed+lep.ed)/(neutron.n+proton.n));
-	t_Pint.set(i,j,k,hc_mev_fm*(th2.pr));
-	t_P.set(i,j,k,hc_mev_fm*(th2.pr+lep.pr));
-	t_Sint.set(i,j,k,hc_mev_fm*(th2.en)/(neutron.n+proton.n));
-	t_S.set(i,j,k,hc_mev_fm*(th2.en+lep.en)/(neutron.n+proton.n));
-	t_mun.set(i,j,k,hc_mev_fm*neutron.mu);
-	t_mup.set(i,j,k,hc_mev_fm*proton.mu);
-
-	double cs2=cs2_fixYe(neutron,proton,T_grid[k]/hc_mev_fm,th2);
-	t_cs2.set(i,j,k,cs2);
-	t_mue.set(i,j,k,eso.electron.mu);
-
-	if (!std::isfinite(th2.ed)) {
-	  cout << "Hadronic energy density not finite." << endl;
-	  cout << "n_B: " << nB_grid[i] << " Y_e: " << Ye_grid[j] << " T: "
-	       << T_grid[k] << endl;
-	  cout << "hadrons ed: " << th2.ed << " pr: " << th2.pr
-	       << " en: " << th2.en << endl;
-	  exit(-1);
-	}
-	if (!std::isfinite(th2.pr)) {
-	  cout << "Hadronic pressure not finite." << endl;
-	  cout << "n_B: " << nB_grid[i] << " Y_e: " << Ye_grid[j] << " T: "
-	       << T_grid[k] << endl;
-	  cout << "hadrons ed: " << th2.ed << " pr: " << th2.pr
-	       << " en: " << th2.en << endl;
-	  exit(-1);
-	}
-	if (!std::isfinite(th2.en)) {
-	  cout << "Hadronic entropy density not finite." << endl;
-	  cout << "n_B: " << nB_grid[i] << " Y_e: " << Ye_grid[j] << " T: "
-	       << T_grid[k] << endl;
-	  cout << "hadrons ed: " << th2.ed << " pr: " << th2.pr
-	       << " en: " << th2.en << endl;
-	  exit(-1);
-	}
-	if (!std::isfinite(lep.ed)) {
-	  cout << "Leptonic energy density not finite." << endl;
-	  cout << "n_B: " << nB_grid[i] << " Y_e: " << Ye_grid[j] << " T: "
-	       << T_grid[k] << endl;
-	  cout << "leptons ed: " << lep.ed << " pr: " << lep.pr
-	       << " en: " << lep.en << endl;
-	  exit(-1);
-	}
-	if (!std::isfinite(lep.pr)) {
-	  cout << "Leptonic pressure not finite." << endl;
-	  cout << "n_B: " << nB_grid[i] << " Y_e: " << Ye_grid[j] << " T: "
-	       << T_grid[k] << endl;
-	  cout << "leptons ed: " << lep.ed << " pr: " << lep.pr
-	       << " en: " << lep.en << endl;
-	  exit(-1);
+  int mpi_rank=0, mpi_size=1;
+#ifndef NO_MPI
+  MPI_Comm_rank(MPI_COMM_WORLD,&mpi_rank);
+  MPI_Comm_size(MPI_COMM_WORLD,&mpi_size);
+#endif
+
+  // ----------------------------------------------------------------
+  // Checkpoint/restart. Completed slabs are flushed to a sidecar
+  // file so an interrupted run only recomputes the slab it was
+  // working on. The sidecar is removed once the final table has
+  // been written.
+
+  std::string ckpt_fname=fname+"_ckpt";
+  std::vector<int> slab_ok(n_nB,0);
+  hdf_file hf_ckpt;
+
+  if (table_checkpoint && mpi_rank==0) {
+
+    std::ifstream fin(ckpt_fname.c_str());
+    bool ckpt_exists=fin.good();
+    fin.close();
+
+    hf_ckpt.open_or_create(ckpt_fname);
+
+    if (ckpt_exists) {
+      size_t ck_nB=0, ck_Ye=0, ck_T=0;
+      hf_ckpt.get_szt("n_nB",ck_nB);
+      hf_ckpt.get_szt("n_Ye",ck_Ye);
+      hf_ckpt.get_szt("n_T",ck_T);
+      // Older checkpoints stored the slabs quantity-major, so
+      // they cannot be restored into the point-major layout
+      size_t ck_layout=0;
+      hf_ckpt.get_szt_def("slab_layout",0,ck_layout);
+      if (ck_nB==n_nB && ck_Ye==n_Ye && ck_T==n_T && ck_layout==1) {
+	hf_ckpt.geti_vec("slab_ok",slab_ok);
+	size_t n_restored=0;
+	for(size_t i=0;i<n_nB;i++) {
+	  if (slab_ok[i]!=0) {
+	    hf_ckpt.getd_vec(((string)"slab_")+szttos(i),slab);
+	    store_slab(i,slab);
+	    n_restored++;
+	  }
 	}
-	if (!std::isfinite(lep.en)) {
-	  cout << "Leptonic entropy density not finite." << endl;
-	  cout << "n_B: " << nB_grid[i] << " Y_e: " << Ye_grid[j] << " T: "
-	       << T_grid[k] << endl;
-	  cout << "leptons ed: " << lep.ed << " pr: " << lep.pr
-	       << " en: " << lep.en << endl;
-	  exit(-1);
+	cout << "Restored " << n_restored << " slabs from "
+	     << ckpt_fname << endl;
+      } else {
+	cout << "Checkpoint file " << ckpt_fname
+	     << " does not match the grid or slab layout, "
+	     << "starting over." << endl;
+	slab_ok.assign(n_nB,0);
+      }
+    }
+
+    hf_ckpt.set_szt("n_nB",n_nB);
+    hf_ckpt.set_szt("n_Ye",n_Ye);
+    hf_ckpt.set_szt("n_T",n_T);
+    hf_ckpt.set_szt("slab_layout",1);
+    hf_ckpt.seti_vec("slab_ok",slab_ok);
+  }
+
+  // The checkpoint writes go through a dedicated writer thread so
+  // the multi-second slab write latency on parallel file systems
+  // overlaps the computation of the next slab. The writer thread
+  // is the only thread touching hf_ckpt and slab_ok entries after
+  // this point.
+  async_block_writer slab_writer;
+  if (table_checkpoint && mpi_rank==0) {
+    slab_writer.start([&](size_t i, const std::vector<double> &sl) {
+	slab_ok[i]=1;
+	hf_ckpt.setd_vec(((string)"slab_")+szttos(i),sl);
+	hf_ckpt.seti_vec("slab_ok",slab_ok);
+      });
+  }
+
+  // Hand one completed slab off to the checkpoint writer
+  auto flush_slab=[&](size_t i) {
+    if (table_checkpoint) {
+      slab_writer.push(i,slab);
+    }
+  };
+
+#ifndef NO_MPI
+
+  if (mpi_size>1) {
+
+    if (mpi_rank>0) {
+
+      // Worker ranks: receive nB indices one at a time, compute the
+      // corresponding slab, and send it back with the index appended.
+      // The dynamic queue keeps the cheap low-density slabs from
+      // leaving ranks idle while others work on the expensive
+      // high-density slabs.
+      std::vector<double> buf(slab_size+1);
+      while (true) {
+	int idx;
+	MPI_Recv(&idx,1,MPI_INT,0,0,MPI_COMM_WORLD,MPI_STATUS_IGNORE);
+	if (idx<0) break;
+	table_full_slab(idx,nB_grid,Ye_grid,T_grid,workers,slab);
+	for(size_t m=0;m<slab_size;m++) buf[m]=slab[m];
+	buf[slab_size]=((double)idx);
+	MPI_Send(&buf[0],slab_size+1,MPI_DOUBLE,0,1,MPI_COMM_WORLD);
+      }
+
+      // Worker ranks do not write the output file
+      return 0;
+
+    } else {
+
+      // The master rank hands out slabs and collects results,
+      // skipping any slabs already restored from the checkpoint
+      std::vector<double> buf(slab_size+1);
+      int next=n_nB-1;
+      while (next>=0 && slab_ok[next]!=0) next--;
+      size_t n_left=0;
+      for(size_t i=0;i<n_nB;i++) {
+	if (slab_ok[i]==0) n_left++;
+      }
+
+      for(int rank=1;rank<mpi_size;rank++) {
+	int idx=-1;
+	if (next>=0) {
+	  idx=next--;
+	  while (next>=0 && slab_ok[next]!=0) next--;
 	}
-	if (th2.en+lep.en<0.0 && th2.pr>0.0) {
-	  cout << "Entropy negative where pressure is positive." << endl;
-	  cout << "n_B: " << nB_grid[i] << " Y_e: " << Ye_grid[j] << " T: "
-	       << T_grid[k] << endl;
-	  cout << "hadrons ed: " << th2.ed << " pr: " << th2.pr
-	       << " en: " << th2.en << endl;
-	  cout << "leptons ed: " << lep.ed << " pr: " << lep.pr
-	       << " en: " << lep.en << endl;
-	  exit(-1);
+	MPI_Send(&idx,1,MPI_INT,rank,0,MPI_COMM_WORLD);
+      }
+
+      for(size_t n_done=0;n_done<n_left;n_done++) {
+	MPI_Status stat;
+	MPI_Recv(&buf[0],slab_size+1,MPI_DOUBLE,MPI_ANY_SOURCE,1,
+		 MPI_COMM_WORLD,&stat);
+	int i=((int)(buf[slab_size]+0.5));
+	cout << "i_nB,n_nB,nB[i]: " << n_nB-1-i << " " << n_nB << " "
+	     << nB_grid[i] << " (rank " << stat.MPI_SOURCE << ")" << endl;
+	slab.assign(buf.begin(),buf.begin()+slab_size);
+	store_slab(i,slab);
+	flush_slab(i);
+	int idx=-1;
+	if (next>=0) {
+	  idx=next--;
+	  while (next>=0 && slab_ok[next]!=0) next--;
 	}
+	MPI_Send(&idx,1,MPI_INT,stat.MPI_SOURCE,0,MPI_COMM_WORLD);
+      }
+
+      slabs_done=true;
+    }
+  }
+
+#endif
+
+  for(int i=n_nB-1;i>=0 && slabs_done==false;i--) {
+    if (slab_ok[i]!=0) continue;
+    cout << "i_nB,n_nB,nB[i]: " << n_nB-1-i << " " << n_nB << " "
+	 << nB_grid[i] << endl;
+
+    table_full_slab(i,nB_grid,Ye_grid,T_grid,workers,slab);
+
+    store_slab(i,slab);
+    flush_slab(i);
+  }
+
+  if (table_checkpoint) {
+    slab_writer.finish();
+    hf_ckpt.close();
+  }
+
+  if (sk_cache.enabled) {
+    size_t cache_hit=sk_cache.n_hit, cache_miss=sk_cache.n_miss;
+    for(size_t it=0;it<workers.size();it++) {
+      cache_hit+=workers[it]->sk_cache.n_hit;
+      cache_miss+=workers[it]->sk_cache.n_miss;
+    }
+    cout << "Skyrme (nB,T) cache hits, misses: " << cache_hit
+	 << " " << cache_miss << endl;
+  }
+
+  if (fug_warm_start) {
+    size_t n_pol=acl.n_batch_newton, n_full=acl.n_batch_quartic;
+    for(size_t it=0;it<workers.size();it++) {
+      n_pol+=workers[it]->acl.n_batch_newton;
+      n_full+=workers[it]->acl.n_batch_quartic;
+    }
+    cout << "Fugacity solves polished, full: " << n_pol << " "
+	 << n_full << endl;
+  }
+
+  // Merge the timing registries from the workers and print the
+  // kernel summary
+  for(size_t it=0;it<workers.size();it++) {
+    stats.add_registry(workers[it]->stats);
+  }
+  if (stats.enabled) {
+    stats.report();
+  }
 
+  // ----------------------------------------------------------------
+  // Post-pass: cells which failed even after the retries in
+  // table_full_point() were stored as NaN. Fill them by linear
+  // interpolation from the nearest finite neighbors along the T
+  // direction and record the failing points in a manifest which
+  // is written to the output file below.
+
+  std::vector<double> fail_nB, fail_Ye, fail_T;
+  if (recover_points) {
+    tensor_grid3<> *tens[12]={&t_Fint,&t_F,&t_Eint,&t_E,&t_Pint,&t_P,
+			      &t_Sint,&t_S,&t_mun,&t_mup,&t_cs2,&t_mue};
+    for(size_t i=0;i<n_nB;i++) {
+      for(size_t j=0;j<n_Ye;j++) {
+	for(size_t k=0;k<n_T;k++) {
+	  if (!std::isfinite(t_F.get(i,j,k))) {
+	    fail_nB.push_back(nB_grid[i]);
+	    fail_Ye.push_back(Ye_grid[j]);
+	    fail_T.push_back(T_grid[k]);
+	    int klo=((int)k)-1;
+	    while (klo>=0 && !std::isfinite(t_F.get(i,j,klo))) klo--;
+	    size_t khi=k+1;
+	    while (khi<n_T && !std::isfinite(t_F.get(i,j,khi))) khi++;
+	    for(size_t q=0;q<12;q++) {
+	      if (klo>=0 && khi<n_T) {
+		double vlo=tens[q]->get(i,j,klo);
+		double vhi=tens[q]->get(i,j,khi);
+		tens[q]->set(i,j,k,vlo+(vhi-vlo)*(T_grid[k]-T_grid[klo])/
+			     (T_grid[khi]-T_grid[klo]));
+	      } else if (klo>=0) {
+		tens[q]->set(i,j,k,tens[q]->get(i,j,klo));
+	      } else if (khi<n_T) {
+		tens[q]->set(i,j,k,tens[q]->get(i,j,khi));
+	      }
+	    }
+	  }
+	}
       }
     }
+    if (fail_nB.size()>0) {
+      cout << "Interpolated " << fail_nB.size()
+	   << " failed points." << endl;
+    }
   }
 
   hdf_file hf;
   hf.open_or_create(fname);
+  hf.compr_type=file_compr;
   hf.set_szt("n_nB",n_nB);
   hf.set_szt("n_Ye",n_Ye);
   hf.set_szt("n_T",n_T);
@@ -2147,10 +3805,158 @@ int eos::table_full(std::vector<std::string> &sv, bool itive_com) {
   hdf_output(hf,t_S,"S");
   hdf_output(hf,t_mun,"mun");
   hdf_output(hf,t_mup,"mup");
-  hdf_output(hf,t_cs2,"cs2");
-  hdf_output(hf,t_mue,"mue");
+  if (store_f32) {
+    // The uncertainty in these two quantities is far above the
+    // float truncation error, so only store them in single
+    // precision
+    tensor_out_f32(hf,t_cs2,"cs2");
+    tensor_out_f32(hf,t_mue,"mue");
+  } else {
+    hdf_output(hf,t_cs2,"cs2");
+    hdf_output(hf,t_mue,"mue");
+  }
+  hf.set_szt("f32_data",store_f32 ? 1 : 0);
+  if (recover_points) {
+    hf.set_szt("n_fail",fail_nB.size());
+    if (fail_nB.size()>0) {
+      hf.setd_vec("fail_nB",fail_nB);
+      hf.setd_vec("fail_Ye",fail_Ye);
+      hf.setd_vec("fail_T",fail_T);
+    }
+  }
+  if (stats.enabled) {
+    stats.hdf_out(hf);
+  }
   hf.close();
-  
+
+  // The table was written successfully, so the checkpoint file
+  // is no longer needed
+  if (table_checkpoint) {
+    remove(ckpt_fname.c_str());
+  }
+
+  return 0;
+}
+
+int eos::table_beta(std::vector<std::string> &sv, bool itive_com) {
+
+  if (sv.size()<3) {
+    cerr << "Command table-beta needs a filename and a temperature "
+	 << "in MeV." << endl;
+    return 1;
+  }
+  std::string fname=sv[1];
+  double T=o2scl::stod(sv[2])/hc_mev_fm;
+
+  if (model_selected==false && use_nrapr==false) {
+    cerr << "No model selected in table-beta." << endl;
+    return 2;
+  }
+
+  // The table_full() baryon density grid
+  size_t n_nB=301;
+  std::string nB_grid_spec="10^(i*0.04-12)*2.0";
+  vector<double> nB_grid;
+  calculator calc;
+  std::map<std::string,double> vars;
+  calc.compile(nB_grid_spec.c_str());
+  for(size_t i=0;i<n_nB;i++) {
+    vars["i"]=((double)i);
+    nB_grid.push_back(calc.eval(&vars));
+  }
+
+  table_units<> t;
+  t.line_of_names("nB Ye F P cs2 mue");
+  t.set_unit("nB","1/fm^3");
+  t.set_unit("F","MeV");
+  t.set_unit("P","MeV/fm^3");
+  t.set_unit("mue","MeV");
+
+  mroot_hybrids<> mh;
+  mh.err_nonconv=false;
+  mh.def_jac.err_nonconv=false;
+
+  int verbose_store=verbose;
+  verbose=0;
+
+  // March from high to low density, warm-starting each solve by
+  // linearly extrapolating the equilibrium Ye from the previous
+  // two densities
+  bool have1=false, have2=false;
+  double nB1=0.0, Ye1=0.0, nB2=0.0, Ye2=0.0;
+  size_t n_fail=0;
+
+  for(int i=((int)n_nB)-1;i>=0;i--) {
+    double nb=nB_grid[i];
+
+    ubvector Ye_trial(1);
+    if (have2) {
+      Ye_trial[0]=Ye1+(Ye1-Ye2)*(nb-nB1)/(nB1-nB2);
+    } else if (have1) {
+      Ye_trial[0]=Ye1;
+    } else {
+      Ye_trial[0]=0.05;
+    }
+    if (Ye_trial[0]<1.0e-4) Ye_trial[0]=1.0e-4;
+    if (Ye_trial[0]>0.6) Ye_trial[0]=0.6;
+
+    mm_funct mf=std::bind
+      (std::mem_fn<int(size_t,const ubvector &,ubvector &,
+		       double,double,double)>
+       (&eos::solve_Ye),this,std::placeholders::_1,
+       std::placeholders::_2,std::placeholders::_3,nb,T,0.0);
+
+    int ret=mh.msolve(1,Ye_trial,mf);
+    if (ret!=0 || Ye_trial[0]<0.0 || Ye_trial[0]>1.0) {
+      n_fail++;
+      continue;
+    }
+    double Ye=Ye_trial[0];
+
+    // Re-evaluate at the root so the electron chemical potential
+    // corresponds to the equilibrium point rather than the last
+    // solver iteration
+    ubvector yy(1);
+    solve_Ye(1,Ye_trial,yy,nb,T,0.0);
+    double mue=electron.mu*hc_mev_fm;
+
+    // Total thermodynamics, as in eval_point()
+    double mun_tot, mup_tot, s_tot, ed_tot;
+    mu_s_total(neutron,proton,nb*(1.0-Ye),nb*Ye,T,th2,
+	       mun_tot,mup_tot,s_tot,ed_tot);
+    double f_tot=ed_tot-T*s_tot;
+    double pr_tot=nb*(1.0-Ye)*mun_tot+nb*Ye*mup_tot-f_tot;
+
+    // The speed of sound along the beta-equilibrium path
+    neutron.n=nb*(1.0-Ye);
+    proton.n=nb*Ye;
+    double cs2=cs2_fixmuL(neutron,proton,T,th2);
+
+    double line[6]={nb,Ye,f_tot/nb*hc_mev_fm,pr_tot*hc_mev_fm,
+		    cs2,mue};
+    t.line_of_data(6,line);
+
+    nB2=nB1;
+    Ye2=Ye1;
+    have2=have1;
+    nB1=nb;
+    Ye1=Ye;
+    have1=true;
+  }
+
+  verbose=verbose_store;
+
+  // The rows were added from high to low density
+  t.sort_table("nB");
+
+  cout << "Command table-beta solved " << t.get_nlines() << " of "
+       << n_nB << " densities (" << n_fail << " failed)." << endl;
+
+  hdf_file hf;
+  hf.open_or_create(fname);
+  hdf_output(hf,t,"table_beta");
+  hf.close();
+
   return 0;
 }
 
@@ -2737,12 +4543,20 @@ int eos::eos_sn(std::vector<std::string> &sv, bool itive_com) {
   
   // -----------------------------------------------------------------
   // LS220
-  
+
   double f, F_eg, fint;
 
-  eso.load("data/LS220_234r_136t_50y_analmu_20091212_SVNr26.h5",
-	   eos_sn_oo::ls_mode);
-  
+  // Each table is parsed from HDF5 only if its memory-mapped
+  // sidecar is missing; otherwise the sidecar is attached
+  // directly and the interpolations below read from the mapping
+  sn_table_cache snc_ls;
+  string ls_fname="data/LS220_234r_136t_50y_analmu_20091212_SVNr26.h5";
+  if (snc_ls.attach(ls_fname)==false) {
+    eso.load(ls_fname,eos_sn_oo::ls_mode);
+    snc_ls.build(ls_fname,eso);
+    snc_ls.attach(ls_fname);
+  }
+
   cout << endl;
   cout << "LS220: " << endl;
   cout << endl;
@@ -2751,17 +4565,18 @@ int eos::eos_sn(std::vector<std::string> &sv, bool itive_com) {
     double lnB=pts[i][0];
     double lYe=pts[i][1];
     double lT=pts[i][2];
-    
+
     cout << "nB: " << lnB << " Ye: " << lYe
 	 << " T: " << lT << endl;
-    f=eso.F.interp_linear(lnB,lYe,lT);
+    f=snc_ls.interp_linear(sn_table_cache::iF,lnB,lYe,lT);
     thermo lep;
     eso.compute_eg_point(lnB,lYe,lT,lep);
     F_eg=(lep.ed-lep.en*lT)/lnB;
-    cout << "F_full,F_eg,Xn,Xa: " 
+    cout << "F_full,F_eg,Xn,Xa: "
 	 << f << " " << F_eg << " "
-	 << eso.Xn.interp_linear(lnB,lYe,lT) << " "
-	 << eso.Xalpha.interp_linear(lnB,lYe,lT) << endl;
+	 << snc_ls.interp_linear(sn_table_cache::iXn,lnB,lYe,lT) << " "
+	 << snc_ls.interp_linear(sn_table_cache::iXalpha,lnB,lYe,lT)
+	 << endl;
     cout << "F_int: " << f-F_eg << endl;
     cout << endl;
   }
@@ -2801,9 +4616,15 @@ int eos::eos_sn(std::vector<std::string> &sv, bool itive_com) {
   // -----------------------------------------------------------------
   // SFHo (O'Connor's table)
 
-  eso.load("data/Hempel_SFHoEOS_rho222_temp180_ye60_version_1.1_20120817.h5",
-	   eos_sn_oo::hfsl_mode);
-  
+  sn_table_cache snc_sfho;
+  string sfho_fname=((string)"data/Hempel_SFHoEOS_rho222_temp180_")+
+    "ye60_version_1.1_20120817.h5";
+  if (snc_sfho.attach(sfho_fname)==false) {
+    eso.load(sfho_fname,eos_sn_oo::hfsl_mode);
+    snc_sfho.build(sfho_fname,eso);
+    snc_sfho.attach(sfho_fname);
+  }
+
   cout << endl;
   cout << "SFHo (O'Connor): " << endl;
   cout << endl;
@@ -2812,17 +4633,18 @@ int eos::eos_sn(std::vector<std::string> &sv, bool itive_com) {
     double lnB=pts[i][0];
     double lYe=pts[i][1];
     double lT=pts[i][2];
-    
+
     cout << "nB: " << lnB << " Ye: " << lYe
 	 << " T: " << lT << endl;
-    f=eso.F.interp_linear(lnB,lYe,lT);
+    f=snc_sfho.interp_linear(sn_table_cache::iF,lnB,lYe,lT);
     thermo lep;
     eso.compute_eg_point(lnB,lYe,lT,lep);
     F_eg=(lep.ed-lep.en*lT)/lnB;
-    cout << "F_full,F_eg,Xn,Xa: " 
+    cout << "F_full,F_eg,Xn,Xa: "
 	 << f << " " << F_eg << " "
-	 << eso.Xn.interp_linear(lnB,lYe,lT) << " "
-	 << eso.Xalpha.interp_linear(lnB,lYe,lT) << endl;
+	 << snc_sfho.interp_linear(sn_table_cache::iXn,lnB,lYe,lT) << " "
+	 << snc_sfho.interp_linear(sn_table_cache::iXalpha,lnB,lYe,lT)
+	 << endl;
     cout << "F_int: " << f-F_eg << endl;
     cout << endl;
   }
@@ -2842,17 +4664,18 @@ int eos::eos_sn(std::vector<std::string> &sv, bool itive_com) {
     double lnB=pts[i][0];
     double lYe=pts[i][1];
     double lT=pts[i][2];
-    
+
     cout << "nB: " << lnB << " Ye: " << lYe
 	 << " T: " << lT << endl;
-    fint=eso.Fint.interp_linear(lnB,lYe,lT);
+    fint=snc_sfho.interp_linear(sn_table_cache::iFint,lnB,lYe,lT);
     thermo lep;
     eso.compute_eg_point(lnB,lYe,lT,lep);
     F_eg=(lep.ed-lep.en*lT)/lnB;
-    cout << "F_full,F_eg,Xn,Xa: " 
+    cout << "F_full,F_eg,Xn,Xa: "
 	 << fint+F_eg << " " << F_eg << " "
-	 << eso.Xn.interp_linear(lnB,lYe,lT) << " "
-	 << eso.Xalpha.interp_linear(lnB,lYe,lT) << endl;
+	 << snc_sfho.interp_linear(sn_table_cache::iXn,lnB,lYe,lT) << " "
+	 << snc_sfho.interp_linear(sn_table_cache::iXalpha,lnB,lYe,lT)
+	 << endl;
     cout << "F_int: " << fint << endl;
     cout << endl;
   }
@@ -2892,8 +4715,14 @@ int eos::eos_sn(std::vector<std::string> &sv, bool itive_com) {
   // -----------------------------------------------------------------
   // SFHx
 
-  eso.load("data/Hempel_SFHxEOS_rho234_temp180_ye60_version_1.1_20120817.h5",
-	   eos_sn_oo::hfsl_mode);
+  sn_table_cache snc_sfhx;
+  string sfhx_fname=((string)"data/Hempel_SFHxEOS_rho234_temp180_")+
+    "ye60_version_1.1_20120817.h5";
+  if (snc_sfhx.attach(sfhx_fname)==false) {
+    eso.load(sfhx_fname,eos_sn_oo::hfsl_mode);
+    snc_sfhx.build(sfhx_fname,eso);
+    snc_sfhx.attach(sfhx_fname);
+  }
 
   cout << endl;
   cout << "SFHx (O'Connor): " << endl;
@@ -2904,17 +4733,19 @@ int eos::eos_sn(std::vector<std::string> &sv, bool itive_com) {
       double lnB=pts[i][0];
       double lYe=pts[i][1];
       double lT=pts[i][2];
-      
+
       cout << "nB: " << lnB << " Ye: " << lYe
 	   << " T: " << lT << endl;
-      fint=eso.Fint.interp_linear(lnB,lYe,lT);
+      fint=snc_sfhx.interp_linear(sn_table_cache::iFint,lnB,lYe,lT);
       thermo lep;
       eso.compute_eg_point(lnB,lYe,lT,lep);
       F_eg=(lep.ed-lep.en*lT)/lnB;
-      cout << "F_full,F_eg,Xn,Xa: " 
+      cout << "F_full,F_eg,Xn,Xa: "
 	   << fint+F_eg << " " << F_eg << " "
-	   << eso.Xn.interp_linear(lnB,lYe,lT) << " "
-	   << eso.Xalpha.interp_linear(lnB,lYe,lT) << endl;
+	   << snc_sfhx.interp_linear(sn_table_cache::iXn,lnB,lYe,lT)
+	   << " "
+	   << snc_sfhx.interp_linear(sn_table_cache::iXalpha,lnB,lYe,lT)
+	   << endl;
       cout << "F_int: " << fint << endl;
       cout << endl;
     }
@@ -2955,8 +4786,14 @@ int eos::eos_sn(std::vector<std::string> &sv, bool itive_com) {
   // -----------------------------------------------------------------
   // IUFSU
 
-  eso.load("data/Hempel_IUFEOS_rho234_temp180_ye60_version_1.1_20140129.h5",
-	   eos_sn_oo::hfsl_mode);
+  sn_table_cache snc_iuf;
+  string iuf_fname=((string)"data/Hempel_IUFEOS_rho234_temp180_")+
+    "ye60_version_1.1_20140129.h5";
+  if (snc_iuf.attach(iuf_fname)==false) {
+    eso.load(iuf_fname,eos_sn_oo::hfsl_mode);
+    snc_iuf.build(iuf_fname,eso);
+    snc_iuf.attach(iuf_fname);
+  }
 
   cout << endl;
   cout << "IUFSU (O'Connor): " << endl;
@@ -2966,17 +4803,18 @@ int eos::eos_sn(std::vector<std::string> &sv, bool itive_com) {
     double lnB=pts[i][0];
     double lYe=pts[i][1];
     double lT=pts[i][2];
-    
+
     cout << "nB: " << lnB << " Ye: " << lYe
 	 << " T: " << lT << endl;
-    fint=eso.Fint.interp_linear(lnB,lYe,lT);
+    fint=snc_iuf.interp_linear(sn_table_cache::iFint,lnB,lYe,lT);
     thermo lep;
     eso.compute_eg_point(lnB,lYe,lT,lep);
     F_eg=(lep.ed-lep.en*lT)/lnB;
-    cout << "F_full,F_eg,Xn,Xa: " 
+    cout << "F_full,F_eg,Xn,Xa: "
 	 << fint+F_eg << " " << F_eg << " "
-	 << eso.Xn.interp_linear(lnB,lYe,lT) << " "
-	 << eso.Xalpha.interp_linear(lnB,lYe,lT) << endl;
+	 << snc_iuf.interp_linear(sn_table_cache::iXn,lnB,lYe,lT) << " "
+	 << snc_iuf.interp_linear(sn_table_cache::iXalpha,lnB,lYe,lT)
+	 << endl;
     cout << "F_int: " << fint << endl;
     cout << endl;
   }
@@ -3124,59 +4962,426 @@ int eos::mcarlo_data(std::vector<std::string> &sv, bool itive_com) {
   vector<double> T_arr={10.0,0.1,10.0,0.1,0.1,10.0};
 
   static const int N=10000;
-  for(int j=0;j<N;j++){
-    
+
+  std::string fname="mcarlo_data";
+  if (sv.size()>1) fname+="_"+sv[1];
+  fname+=".o2";
+
+  // Compute one Monte Carlo row on the specified object
+  auto mcarlo_line=[&nB_arr,&Ye_arr,&T_arr](eos *w, int j,
+					    vector<double> &line) {
     std::vector<std::string> obj;
-    random(obj,false);
+    w->random(obj,false);
+
+    line={((double)j),w->eos_S,w->eos_L,w->qmc_a,w->qmc_b,w->qmc_alpha,
+	  w->qmc_beta,((double)w->i_ns),((double)w->i_skyrme),w->phi,
+	  w->eos_n0,w->eos_EoA,w->eos_K,w->chi2_ns,w->ns_fit_parms[0],
+	  w->ns_fit_parms[1],w->ns_fit_parms[2],w->ns_fit_parms[3],
+	  w->ns_fit_parms[4]};
 
-    vector<double> line={((double)j),eos_S,eos_L,qmc_a,qmc_b,qmc_alpha,
-			 qmc_beta,((double)i_ns),((double)i_skyrme),phi,
-			 eos_n0,eos_EoA,eos_K,chi2_ns,ns_fit_parms[0],
-			 ns_fit_parms[1],ns_fit_parms[2],ns_fit_parms[3],
-			 ns_fit_parms[4]};
-    
     for(size_t k=0;k<6;k++) {
-      neutron.n=nB_arr[k]*(1.0-Ye_arr[k]);
-      proton.n=nB_arr[k]*Ye_arr[k];
+      w->neutron.n=nB_arr[k]*(1.0-Ye_arr[k]);
+      w->proton.n=nB_arr[k]*Ye_arr[k];
       double T=T_arr[k]/hc_mev_fm;
-      if (use_nrapr) {
-	line.push_back(sk_nrapr.calc_temp_e(neutron,proton,T,th2)/
+      if (w->use_nrapr) {
+	line.push_back(w->sk_nrapr.calc_temp_e(w->neutron,w->proton,
+					       T,w->th2)/
 		       nB_arr[k]*hc_mev_fm);
       } else {
-	line.push_back(free_energy_density(neutron,proton,T,th2)/
+	line.push_back(w->free_energy_density(w->neutron,w->proton,
+					      T,w->th2)/
 		       nB_arr[k]*hc_mev_fm);
       }
     }
 
     double ns_min_cs2, ns_max_cs2;
-    min_max_cs2(ns_min_cs2,ns_max_cs2);
+    w->min_max_cs2(ns_min_cs2,ns_max_cs2);
     line.push_back(ns_min_cs2);
     line.push_back(ns_max_cs2);
 
-    line.push_back(Lambda_bar_14);
-    
+    line.push_back(w->Lambda_bar_14);
+  };
+
+  if (n_threads>1) {
+
+    // Thread-parallel scan. Each worker runs a contiguous block
+    // of iterations with an independent RNG stream and its own
+    // copies of the evaluation objects, and the blocks are
+    // merged in worker order afterwards so the output layout is
+    // deterministic.
+    size_t nth=n_threads;
+    std::vector<std::shared_ptr<eos> > workers;
+    make_workers(workers,nth);
+
+    // Reproducibly distinct RNG streams derived from the parent
+    // generator
+    for(size_t it=0;it<nth;it++) {
+      workers[it]->r.set_seed(r.random_int(1000000000));
+    }
+
+    std::vector<std::vector<vector<double> > > rows(nth);
+    std::vector<std::thread> th_arr;
+    for(size_t it=0;it<nth;it++) {
+      eos *w=workers[it].get();
+      int j_start=((int)(it*N/nth));
+      int j_end=((int)((it+1)*N/nth));
+      std::vector<vector<double> > *rp=&(rows[it]);
+      th_arr.push_back(std::thread
+		       ([w,j_start,j_end,rp,&mcarlo_line]() {
+			 for(int j=j_start;j<j_end;j++) {
+			   vector<double> line;
+			   mcarlo_line(w,j,line);
+			   rp->push_back(line);
+			 }
+		       }));
+    }
+    for(size_t it=0;it<nth;it++) {
+      th_arr[it].join();
+    }
+
+    for(size_t it=0;it<nth;it++) {
+      for(size_t m=0;m<rows[it].size();m++) {
+	t.line_of_data(rows[it][m].size(),rows[it][m]);
+	if (rows[it][m].size()!=t.get_ncolumns()) {
+	  O2SCL_ERR("Table sync error in mcarlo_data().",exc_esanity);
+	}
+      }
+    }
+
+    hdf_file hf1;
+    hf1.open_or_create(fname);
+    o2scl_hdf::hdf_output(hf1,t,"mcarlo");
+    hf1.close();
+
+    for(size_t it=0;it<nth;it++) {
+      stats.add_registry(workers[it]->stats);
+    }
+    if (stats.enabled) {
+      stats.report();
+    }
+
+    return 0;
+  }
+
+  // Append new rows incrementally instead of rewriting the whole
+  // accumulated table at every checkpoint
+  table_append_writer taw;
+  taw.flush_interval=flush_interval;
+  taw.open(fname);
+
+  for(int j=0;j<N;j++){
+
+    vector<double> line;
+    mcarlo_line(this,j,line);
+
     cout << "Line: ";
     for(size_t i=0;i<line.size();i++) {
       cout << line[i] << " ";
     }
     cout << endl;
-    
+
     t.line_of_data(line.size(),line);
     if (line.size()!=t.get_ncolumns()) {
       O2SCL_ERR("Table sync error in mcarlo_data().",exc_esanity);
     }
 
-    if (j%10==0 || j==N-1) {
-      hdf_file hf1;
-      std::string fname="mcarlo_data";
-      if (sv.size()>1) fname+="_"+sv[1];
-      fname+=".o2";
-      hf1.open_or_create(fname);
-      o2scl_hdf::hdf_output(hf1,t,"mcarlo");
-      hf1.close();
-    }    
+    taw.append(line);
   }
-    
+
+  taw.finish(t,"mcarlo");
+
+  if (stats.enabled) {
+    stats.report();
+  }
+
+  return 0;
+}
+
+int eos::ns_fit_gen(std::vector<std::string> &sv, bool itive_com) {
+
+  load_data_tables();
+
+  size_t n_rows=nstar_tab.get_nlines();
+  std::vector<double> parms_all(5*n_rows), chi2_all(n_rows),
+    nb_max_all(n_rows);
+
+  // Force the full nonlinear fit for every row
+  bool cache_temp=use_ns_fit_cache;
+  use_ns_fit_cache=false;
+  int verbose_temp=verbose;
+  verbose=0;
+
+  for(size_t i=0;i<n_rows;i++) {
+    ns_fit(i);
+    for(size_t k=0;k<5;k++) {
+      parms_all[i*5+k]=ns_fit_parms[k];
+    }
+    chi2_all[i]=chi2_ns;
+    nb_max_all[i]=ns_nb_max;
+    if (i%100==99) {
+      cout << "ns_fit_gen: finished row " << i+1 << " of "
+	   << n_rows << "." << endl;
+    }
+  }
+
+  use_ns_fit_cache=cache_temp;
+  verbose=verbose_temp;
+
+  o2scl_hdf::hdf_file hf;
+  hf.open_or_create("data/ns_fit_cache.o2");
+  hf.set_szt("n_rows",n_rows);
+  hf.setd_vec("parms",parms_all);
+  hf.setd_vec("chi2",chi2_all);
+  hf.setd_vec("nb_max",nb_max_all);
+  hf.close();
+
+  // Make the freshly computed results available immediately
+  ns_cache_parms=parms_all;
+  ns_cache_chi2=chi2_all;
+  ns_cache_nb_max=nb_max_all;
+  ns_cache_checked=true;
+  ns_cache_loaded=true;
+
+  cout << "ns_fit_gen: wrote " << n_rows << " fits to "
+       << "data/ns_fit_cache.o2." << endl;
+
+  return 0;
+}
+
+int eos::bench(std::vector<std::string> &sv, bool itive_com) {
+
+  // Benchmarks need a selected model; use a fixed seed so the
+  // model, and thus the timings, are reproducible across commits
+  if (model_selected==false) {
+    r.set_seed(10);
+    std::vector<std::string> tmp_sv;
+    random(tmp_sv,false);
+  }
+
+  int verbose_temp=verbose;
+  verbose=0;
+
+  // One line per kernel: name, calls, ns/call, calls/sec
+  auto report=[](string name, size_t n_calls, double ns_tot) {
+    cout << "bench " << name << " " << n_calls << " "
+	 << ns_tot/((double)n_calls) << " "
+	 << ((double)n_calls)/ns_tot*1.0e9 << endl;
+    return;
+  };
+
+  typedef std::chrono::high_resolution_clock bench_clock;
+  auto elapsed_ns=[](bench_clock::time_point t1,
+		     bench_clock::time_point t2) {
+    return ((double)std::chrono::duration_cast
+	    <std::chrono::nanoseconds>(t2-t1).count());
+  };
+
+  // ----------------------------------------------------------
+  // free_energy_density() in the virial, transition, and
+  // degenerate regimes. The densities are perturbed slightly at
+  // each call so the Skyrme correction cache does not short-
+  // circuit the evaluation.
+
+  static const size_t n_fed=1000;
+  double fed_nB[3]={1.0e-3,0.05,0.5};
+  double fed_T[3]={10.0,5.0,1.0};
+  string fed_name[3]={"fed_virial","fed_transition","fed_degenerate"};
+
+  for(size_t ir=0;ir<3;ir++) {
+    double Tx=fed_T[ir]/hc_mev_fm;
+    bench_clock::time_point t1=bench_clock::now();
+    for(size_t i=0;i<n_fed;i++) {
+      double nBx=fed_nB[ir]*(1.0+1.0e-6*((double)i));
+      neutron.n=nBx*0.6;
+      proton.n=nBx*0.4;
+      free_energy_density(neutron,proton,Tx,th2);
+    }
+    bench_clock::time_point t2=bench_clock::now();
+    report(fed_name[ir],n_fed,elapsed_ns(t1,t2));
+  }
+
+  // ----------------------------------------------------------
+  // The virial fugacity solver
+
+  {
+    static const size_t n_fug=10000;
+    double T_MeV=5.0;
+    double Tx=T_MeV/hc_mev_fm;
+    double b_n=ecv.bn_f(T_MeV);
+    double b_pn=ecv.bpn_f(T_MeV);
+    double lambda=sqrt(4.0*o2scl_const::pi/(neutron.m+proton.m)/Tx);
+    ubvector x(2);
+    bench_clock::time_point t1=bench_clock::now();
+    for(size_t i=0;i<n_fug;i++) {
+      acl.nn=0.01*(1.0+1.0e-6*((double)i));
+      acl.pn=0.008;
+      acl.T=Tx;
+      acl.b_n=b_n;
+      acl.b_pn=b_pn;
+      acl.lambda=lambda;
+      acl.solve_fugacity(x);
+    }
+    bench_clock::time_point t2=bench_clock::now();
+    report("solve_fugacity",n_fug,elapsed_ns(t1,t2));
+  }
+
+  // ----------------------------------------------------------
+  // The batched fugacity solver, timed and validated against the
+  // scalar solver point by point
+
+  {
+    static const size_t n_batch=10000;
+    std::vector<double> nn_arr(n_batch), pn_arr(n_batch),
+      T_arr(n_batch), lambda_arr(n_batch), b_n_arr(n_batch),
+      b_pn_arr(n_batch), zn_arr, zp_arr;
+
+    // A temperature sweep at fixed densities, as in the table
+    // inner loop
+    for(size_t i=0;i<n_batch;i++) {
+      double T_MeV=1.0+9.0*((double)i)/((double)(n_batch-1));
+      double Tx=T_MeV/hc_mev_fm;
+      nn_arr[i]=0.01;
+      pn_arr[i]=0.008;
+      T_arr[i]=Tx;
+      lambda_arr[i]=sqrt(4.0*o2scl_const::pi/(neutron.m+proton.m)/Tx);
+      b_n_arr[i]=ecv.bn_f(T_MeV);
+      b_pn_arr[i]=ecv.bpn_f(T_MeV);
+    }
+
+    // Count only this batch, restoring the counters afterwards so
+    // the warm-start report below is unaffected
+    size_t sv_n=acl.n_batch_newton, sv_q=acl.n_batch_quartic,
+      sv_s=acl.n_batch_scalar;
+    acl.n_batch_newton=0;
+    acl.n_batch_quartic=0;
+    acl.n_batch_scalar=0;
+
+    bench_clock::time_point t1=bench_clock::now();
+    acl.solve_fugacity_batch(n_batch,nn_arr,pn_arr,T_arr,lambda_arr,
+			     b_n_arr,b_pn_arr,zn_arr,zp_arr);
+    bench_clock::time_point t2=bench_clock::now();
+    report("solve_fugacity_batch",n_batch,elapsed_ns(t1,t2));
+
+    cout << "bench solve_fugacity_batch paths (newton, quartic, "
+	 << "scalar): " << acl.n_batch_newton << " "
+	 << acl.n_batch_quartic << " " << acl.n_batch_scalar << endl;
+
+    double max_dev=0.0;
+    ubvector xb(2);
+    for(size_t i=0;i<n_batch;i+=10) {
+      acl.nn=nn_arr[i];
+      acl.pn=pn_arr[i];
+      acl.T=T_arr[i];
+      acl.lambda=lambda_arr[i];
+      acl.b_n=b_n_arr[i];
+      acl.b_pn=b_pn_arr[i];
+      acl.solve_fugacity(xb);
+      double dev=fabs(zn_arr[i]-acl.zn)/acl.zn;
+      double dev2=fabs(zp_arr[i]-acl.zp)/acl.zp;
+      if (dev2>dev) dev=dev2;
+      if (dev>max_dev) max_dev=dev;
+    }
+    cout << "bench solve_fugacity_batch max rel. dev.: "
+	 << max_dev << endl;
+
+    acl.n_batch_newton=sv_n;
+    acl.n_batch_quartic=sv_q;
+    acl.n_batch_scalar=sv_s;
+  }
+
+  // ----------------------------------------------------------
+  // Validate the warm-started fugacity path against the
+  // closed-form solver over a sweep through the virial and
+  // transition regions
+
+  {
+    static const size_t n_val=200;
+    double Tx=4.0/hc_mev_fm;
+    double max_dev=0.0;
+    bool warm_temp=fug_warm_start;
+    for(size_t i=0;i<n_val;i++) {
+      double nBx=1.0e-4*pow(1.0e3,((double)i)/((double)(n_val-1)));
+      neutron.n=nBx*0.6;
+      proton.n=nBx*0.4;
+      fug_warm_start=false;
+      double f_cold=free_energy_density(neutron,proton,Tx,th2);
+      neutron.n=nBx*0.6;
+      proton.n=nBx*0.4;
+      fug_warm_start=true;
+      double f_warm=free_energy_density(neutron,proton,Tx,th2);
+      double dev=fabs(f_warm-f_cold)/(fabs(f_cold)+1.0e-10);
+      if (dev>max_dev) max_dev=dev;
+    }
+    fug_warm_start=warm_temp;
+    cout << "bench fug_warm_start max rel. dev.: " << max_dev << endl;
+    cout << "bench fugacity paths (newton, quartic, scalar): "
+	 << acl.n_batch_newton << " " << acl.n_batch_quartic << " "
+	 << acl.n_batch_scalar << endl;
+  }
+
+  // ----------------------------------------------------------
+  // The speed of sound at fixed Ye
+
+  {
+    static const size_t n_cs2=100;
+    double Tx=5.0/hc_mev_fm;
+    bench_clock::time_point t1=bench_clock::now();
+    for(size_t i=0;i<n_cs2;i++) {
+      double nBx=0.16*(1.0+1.0e-6*((double)i));
+      neutron.n=nBx*0.7;
+      proton.n=nBx*0.3;
+      cs2_fixYe(neutron,proton,Tx,th2);
+    }
+    bench_clock::time_point t2=bench_clock::now();
+    report("cs2_fixYe",n_cs2,elapsed_ns(t1,t2));
+  }
+
+  // ----------------------------------------------------------
+  // The full neutron star fit, bypassing the fit cache. The
+  // currently selected row is refit so the model is unchanged.
+
+  {
+    static const size_t n_nsf=5;
+    bool cache_temp=use_ns_fit_cache;
+    use_ns_fit_cache=false;
+    bench_clock::time_point t1=bench_clock::now();
+    for(size_t i=0;i<n_nsf;i++) {
+      ns_fit(i_ns);
+    }
+    bench_clock::time_point t2=bench_clock::now();
+    use_ns_fit_cache=cache_temp;
+    report("ns_fit",n_nsf,elapsed_ns(t1,t2));
+  }
+
+  // ----------------------------------------------------------
+  // A miniature table slab, using the same point function as
+  // table_full()
+
+  {
+    eos_sn_oo eso;
+    double res[12];
+    bool recover_temp=recover_points;
+    recover_points=true;
+    size_t n_pts=0;
+    bench_clock::time_point t1=bench_clock::now();
+    for(size_t i=0;i<8;i++) {
+      double nBx=0.01*pow(20.0,((double)i)/7.0);
+      for(size_t j=0;j<5;j++) {
+	double Yex=0.1+0.1*((double)j);
+	for(size_t k=0;k<5;k++) {
+	  double Tx=1.0+2.0*((double)k);
+	  table_full_point(nBx,Yex,Tx,eso,res);
+	  n_pts++;
+	}
+      }
+    }
+    bench_clock::time_point t2=bench_clock::now();
+    recover_points=recover_temp;
+    report("table_point",n_pts,elapsed_ns(t1,t2));
+  }
+
+  verbose=verbose_temp;
+
   return 0;
 }
 
@@ -3186,6 +5391,11 @@ int eos::vir_comp(std::vector<std::string> &sv, bool itive_com) {
   t.line_of_names("log_nB F");
   t2.line_of_names("log_nB zn F_vir");
 
+  // Append new rows incrementally so a partial scan is not lost
+  table_append_writer taw;
+  taw.flush_interval=flush_interval;
+  taw.open("vir_comp.o2");
+
   for(int j=0;j<1000;j++){
     std::vector<std::string> obj;
     random(obj,false);
@@ -3197,6 +5407,7 @@ int eos::vir_comp(std::vector<std::string> &sv, bool itive_com) {
       double line[2]={log10(nb),free_energy_density(neutron,proton,T,th2)/
 		      nb*hc_mev_fm};
       t.line_of_data(2,line);
+      taw.append({line[0],line[1]});
       if (j==0) {
 	double F_vir=free_energy_density_virial(neutron,proton,T,th2)/
 	  nb*hc_mev_fm;
@@ -3206,13 +5417,14 @@ int eos::vir_comp(std::vector<std::string> &sv, bool itive_com) {
       }
     }
   }
-  
+
+  taw.finish(t,"vir_comp");
+
   hdf_file hf;
   hf.open_or_create("vir_comp.o2");
-  hdf_output(hf,t,"vir_comp");
   hdf_output(hf,t2,"vir_comp2");
   hf.close();
-  
+
   return 0;
 }
 
@@ -3231,10 +5443,32 @@ int eos::pns_eos(std::vector<std::string> &sv, bool itive_com) {
   x[1]=10.0/hc_mev_fm;
 
   double Ye0=0.0, T0=0.0;
-  
-  for(double nB=0.08;nB<1.5;nB+=0.01) {
-    
-    mroot_hybrids<> mh;
+
+  // March along the density grid as a continuation problem. The
+  // initial guess for each solve is extrapolated from the previous
+  // two solutions, and the density step is halved when the solver
+  // fails to converge and grown back towards the base step after
+  // successes, so an isolated difficult region no longer aborts
+  // the whole sequence.
+  static const double nB_start=0.08, nB_end=1.5;
+  static const double dnB_base=0.01;
+  static const double dnB_min=dnB_base/64.0;
+
+  mroot_hybrids<> mh;
+  mh.verbose=0;
+  mh.err_nonconv=false;
+  mh.def_jac.err_nonconv=false;
+
+  // The previous two accepted solutions
+  double nB1=0.0, nB2=0.0;
+  ubvector x1(2), x2(2);
+  size_t n_acc=0;
+
+  double nB=nB_start;
+  double dnB=dnB_base;
+
+  while (nB<nB_end) {
+
     mm_funct pns=std::bind
       (std::mem_fn<int(size_t,const ubvector &,
 		       ubvector &, double, double, double)>
@@ -3242,22 +5476,60 @@ int eos::pns_eos(std::vector<std::string> &sv, bool itive_com) {
        this,std::placeholders::_1,
        std::placeholders::_2,
        std::placeholders::_3,nB,sonb,YL);
-    mh.verbose=0;
-    mh.msolve(2,x,pns);
+
+    // Extrapolate the initial guess from the previous two
+    // solutions when they are available
+    if (n_acc>=2) {
+      double fact=(nB-nB1)/(nB1-nB2);
+      x[0]=x1[0]+(x1[0]-x2[0])*fact;
+      x[1]=x1[1]+(x1[1]-x2[1])*fact;
+    } else if (n_acc==1) {
+      x[0]=x1[0];
+      x[1]=x1[1];
+    }
+
+    int ret=mh.msolve(2,x,pns);
+
+    if (ret!=0) {
+      // Nonconvergence: bisect the step from the last accepted
+      // point and try again
+      if (dnB>dnB_min) {
+	double nB_last=(n_acc>0?nB1:nB_start-dnB_base);
+	dnB/=2.0;
+	nB=nB_last+dnB;
+	continue;
+      }
+      cout << "Command pns-eos failed to converge at nB=" << nB
+	   << " with the minimum step size. Stopping the march."
+	   << endl;
+      break;
+    }
 
     cout << nB << " " << x[0] << " " << x[1] << endl;
-    if (nB<0.08*1.001) {
+    if (n_acc==0) {
       Ye0=x[0];
       T0=x[1];
     }
-    
+
     vector<double> line={nB,x[0],x[1],th2.ed+electron.ed+photon.ed+
 			 neutron.m*neutron.n+proton.m*proton.n,
 			 th2.pr+electron.pr+photon.pr,neutron.n,
 			 proton.n,neutron.mu,proton.mu,electron.n,
 			 electron.mu};
     eost.line_of_data(line);
-    
+
+    nB2=nB1;
+    x2=x1;
+    nB1=nB;
+    x1=x;
+    n_acc++;
+
+    // Grow the step back towards the base step after a success
+    if (dnB<dnB_base) {
+      dnB*=2.0;
+      if (dnB>dnB_base) dnB=dnB_base;
+    }
+    nB+=dnB;
   }
 
   x[0]=Ye0;
@@ -3357,17 +5629,16 @@ int eos::select_internal(int i_ns_loc, int i_skyrme_loc,
   eos_L=eos_L_loc;
   eos_S=eos_S_loc;
   phi=phi_loc;
-  
+
   model_selected=true;
 
-  ns_fit(i_ns);
-  
-  double ns_min_cs2, ns_max_cs2;
-  min_max_cs2(ns_min_cs2,ns_max_cs2);
-  if (ns_min_cs2<0.0) {
-    model_selected=false;
-    return 1;
-  }
+  load_data_tables();
+
+  // The cached Skyrme evaluations refer to the previous model
+  sk_cache.clear();
+
+  // Apply the cheap analytic cuts before any EOS evaluation so
+  // that rejection sampling fails fast
 
   if (9.17*eos_S-266.0>eos_L || 14.3*eos_S-379.0<eos_L) {
     model_selected=false;
@@ -3377,7 +5648,7 @@ int eos::select_internal(int i_ns_loc, int i_skyrme_loc,
   double rho0=UNEDF_tab.get(((string)"rho0"),i_skyrme);
   double Crdr0=UNEDF_tab.get(((string)"Crdr0"),i_skyrme);
   double Vp=UNEDF_tab.get(((string)"Vp"),i_skyrme);
-  double EoA=UNEDF_tab.get(((string)"EoA"),i_skyrme); 
+  double EoA=UNEDF_tab.get(((string)"EoA"),i_skyrme);
   double Crdr1=UNEDF_tab.get(((string)"Crdr1"),i_skyrme);
   double CrdJ0=UNEDF_tab.get(((string)"CrdJ0"),i_skyrme);
   double K=UNEDF_tab.get(((string)"K"),i_skyrme);
@@ -3389,16 +5660,25 @@ int eos::select_internal(int i_ns_loc, int i_skyrme_loc,
   eos_n0=rho0;
   eos_EoA=EoA;
   eos_K=K;
-    
+
   // Determine QMC coefficients
   qmc_b=eos_S+EoA-qmc_a;
   qmc_beta=(eos_L/3.0-qmc_a*qmc_alpha)/qmc_b;
-    
+
   if (qmc_b<0.0 || qmc_beta>5.0) {
     model_selected=false;
     return 3;
   }
-  
+
+  ns_fit(i_ns);
+
+  double ns_min_cs2, ns_max_cs2;
+  min_max_cs2(ns_min_cs2,ns_max_cs2);
+  if (ns_min_cs2<0.0) {
+    model_selected=false;
+    return 1;
+  }
+
   double Ms_star=1/Ms_inv;
     
   sk.alt_params_saturation(rho0,EoA/hc_mev_fm,K/hc_mev_fm,Ms_star,
@@ -3467,7 +5747,9 @@ int eos::select_internal(int i_ns_loc, int i_skyrme_loc,
   // Test beta equilibrium
   
   // Loop over baryon densities
-  cout << "Going to beta-eq test: " << endl;
+  if (verbose>0) {
+    cout << "Going to beta-eq test: " << endl;
+  }
   for(double nbx=0.1;nbx<2.00001;nbx+=0.05) {
     
     // Beta equilibrium at T=1 MeV
@@ -3508,7 +5790,9 @@ int eos::select_internal(int i_ns_loc, int i_skyrme_loc,
   model_selected=true;
 
   if (select_cs2_test) {
-    cout << "Going to cs2 test: " << endl;
+    if (verbose>0) {
+      cout << "Going to cs2 test: " << endl;
+    }
     for(double nbx=0.1;nbx<2.00001;nbx+=0.05) {
       for(double yex=0.05;yex<0.4501;yex+=0.1) {
 	for(double Tx=1.0/hc_mev_fm;Tx<10.01/hc_mev_fm;Tx+=9.0/hc_mev_fm) {
@@ -3522,7 +5806,7 @@ int eos::select_internal(int i_ns_loc, int i_skyrme_loc,
 	      cout << "Negative speed of sound." << endl;
 	      cout << nbx << " " << yex << " " << Tx*hc_mev_fm << endl;
 	      exit(-1);
-	    }	    
+	    }
 	  }
 	}
       }
@@ -3532,8 +5816,179 @@ int eos::select_internal(int i_ns_loc, int i_skyrme_loc,
   return 0;
 }
 
+int eos::screen_models(const std::vector<std::vector<double> > &cands,
+		       std::vector<int> &codes) {
+
+  load_data_tables();
+
+  size_t n_cand=cands.size();
+  codes.resize(n_cand);
+
+  // First pass: the analytic cuts, which need only a table lookup
+  // per candidate. The survivors are collected into a work list.
+  std::vector<size_t> surv;
+  for(size_t i=0;i<n_cand;i++) {
+    if (cands[i].size()!=7) {
+      O2SCL_ERR("Candidate size mismatch in screen_models().",
+		exc_einval);
+    }
+    double qmc_alpha_c=cands[i][2];
+    double qmc_a_c=cands[i][3];
+    double L_c=cands[i][4];
+    double S_c=cands[i][5];
+    if (9.17*S_c-266.0>L_c || 14.3*S_c-379.0<L_c) {
+      codes[i]=2;
+      continue;
+    }
+    int i_skyrme_c=((int)(cands[i][1]+1.0e-10));
+    double EoA_c=UNEDF_tab.get(((string)"EoA"),i_skyrme_c);
+    double qmc_b_c=S_c+EoA_c-qmc_a_c;
+    double qmc_beta_c=(L_c/3.0-qmc_a_c*qmc_alpha_c)/qmc_b_c;
+    if (qmc_b_c<0.0 || qmc_beta_c>5.0) {
+      codes[i]=3;
+      continue;
+    }
+    surv.push_back(i);
+  }
+
+  if (verbose>0) {
+    cout << "screen_models(): " << surv.size() << " of " << n_cand
+	 << " candidates survive the analytic cuts." << endl;
+  }
+  if (surv.size()==0) return 0;
+
+  // Second pass: the expensive checks. Worker copies are used
+  // even in the serial case so that the model currently selected
+  // in this object is left intact.
+  size_t nth=n_threads;
+  if (nth<1) nth=1;
+  if (nth>surv.size()) nth=surv.size();
+  std::vector<std::shared_ptr<eos> > workers;
+  make_workers(workers,nth);
+
+  std::atomic<size_t> next_surv(0);
+
+  auto screen_block=[&](size_t it) {
+    eos *w=workers[it].get();
+    w->verbose=0;
+    size_t j;
+    while ((j=next_surv++)<surv.size()) {
+      size_t i=surv[j];
+      codes[i]=w->select_internal
+	(((int)(cands[i][0]+1.0e-10)),((int)(cands[i][1]+1.0e-10)),
+	 cands[i][2],cands[i][3],cands[i][4],cands[i][5],cands[i][6]);
+    }
+    return;
+  };
+
+  if (nth>1) {
+    std::vector<std::thread> th_list;
+    for(size_t it=0;it<nth;it++) {
+      th_list.push_back(std::thread(screen_block,it));
+    }
+    for(size_t it=0;it<nth;it++) {
+      th_list[it].join();
+    }
+  } else {
+    screen_block(0);
+  }
+
+  if (verbose>0) {
+    size_t n_pass=0;
+    for(size_t i=0;i<n_cand;i++) {
+      if (codes[i]==0) n_pass++;
+    }
+    cout << "screen_models(): " << n_pass << " of " << n_cand
+	 << " candidates pass all checks." << endl;
+  }
+
+  return 0;
+}
+
+int eos::select_params(int i_ns_loc, int i_skyrme_loc,
+		       double qmc_alpha_loc, double qmc_a_loc,
+		       double eos_L_loc, double eos_S_loc,
+		       double phi_loc) {
+  return select_internal(i_ns_loc,i_skyrme_loc,qmc_alpha_loc,
+			 qmc_a_loc,eos_L_loc,eos_S_loc,phi_loc);
+}
+
+std::shared_ptr<eos> eos::clone() {
+  std::vector<std::shared_ptr<eos> > workers;
+  make_workers(workers,1);
+  return workers[0];
+}
+
+int eos::eval_point(double nB, double Ye, double T_MeV,
+		    double &F, double &P, double &S,
+		    double &mun, double &mup) {
+
+  // Serve the query from the loaded table when possible
+  if (eos_table_loaded) {
+    double res[12];
+    if (table_interp_point(nB,Ye,T_MeV,res)) {
+      F=res[1];
+      P=res[5];
+      S=res[7];
+      mun=res[8];
+      mup=res[9];
+      return 0;
+    }
+  }
+
+  if (model_selected==false && use_nrapr==false) {
+    O2SCL_ERR("No model selected in eval_point().",exc_einval);
+  }
+
+  double T=T_MeV/hc_mev_fm;
+  double nn=nB*(1.0-Ye);
+  double np=nB*Ye;
+
+  double mun_tot, mup_tot, s_tot, ed_tot;
+  mu_s_total(neutron,proton,nn,np,T,th2,mun_tot,mup_tot,
+	     s_tot,ed_tot);
+
+  // The pressure from the thermodynamic identity, which also
+  // picks up the photon contribution since photons have no
+  // density term
+  double f_tot=ed_tot-T*s_tot;
+  double pr_tot=nn*mun_tot+np*mup_tot-f_tot;
+
+  F=f_tot/nB*hc_mev_fm;
+  P=pr_tot*hc_mev_fm;
+  S=s_tot/nB;
+  mun=mun_tot*hc_mev_fm;
+  mup=mup_tot*hc_mev_fm;
+
+  return 0;
+}
+
+int eos::cs2_point(double nB, double Ye, double T_MeV, double &cs2) {
+
+  // Serve the query from the loaded table when possible
+  if (eos_table_loaded) {
+    double res[12];
+    if (table_interp_point(nB,Ye,T_MeV,res)) {
+      cs2=res[10];
+      return 0;
+    }
+  }
+
+  if (model_selected==false && use_nrapr==false) {
+    O2SCL_ERR("No model selected in cs2_point().",exc_einval);
+  }
+
+  neutron.n=nB*(1.0-Ye);
+  proton.n=nB*Ye;
+  cs2=cs2_fixYe(neutron,proton,T_MeV/hc_mev_fm,th2);
+
+  return 0;
+}
+
 int eos::random(std::vector<std::string> &sv, bool itive_com) {
 
+  load_data_tables();
+
   // This function never fails, and it requires a call to
   // free_energy_density(), so we set this to true
   model_selected=true;
@@ -3599,12 +6054,140 @@ int eos::random(std::vector<std::string> &sv, bool itive_com) {
   return 0;
 }
 
+int eos::load_table(std::vector<std::string> &sv, bool itive_com) {
+
+  if (sv.size()<2) {
+    cerr << "Command load-table needs a filename." << endl;
+    return 1;
+  }
+  std::string fname=sv[1];
+
+  hdf_file hf;
+  hf.open(fname);
+
+  size_t n_nB=0, n_Ye=0, n_T=0;
+  hf.get_szt("n_nB",n_nB);
+  hf.get_szt("n_Ye",n_Ye);
+  hf.get_szt("n_T",n_T);
+
+  hf.getd_vec("nB_grid",eos_tab_nB);
+  hf.getd_vec("Ye_grid",eos_tab_Ye);
+  hf.getd_vec("T_grid",eos_tab_T);
+
+  // Tables written with store_f32 keep cs2 and mue as flat
+  // single-precision arrays rather than tensors
+  size_t f32=0;
+  hf.get_szt_def("f32_data",0,f32);
+
+  // Fuse the twelve per-quantity tensors into the point-major
+  // layout so that a multi-quantity lookup touches one cache
+  // neighborhood
+  static const char *qnames[12]={"Fint","F","Eint","E","Pint","P",
+				 "Sint","S","mun","mup","cs2","mue"};
+  eos_tab_data.resize(n_nB*n_Ye*n_T*12);
+  for(size_t q=0;q<12;q++) {
+    if (f32!=0 && (q==10 || q==11)) {
+      std::vector<float> fv;
+      hf.getf_vec(qnames[q],fv);
+      for(size_t m=0;m<n_nB*n_Ye*n_T;m++) {
+	eos_tab_data[m*12+q]=fv[m];
+      }
+    } else {
+      tensor_grid3<> tg;
+      hdf_input(hf,tg,qnames[q]);
+      for(size_t i=0;i<n_nB;i++) {
+	for(size_t j=0;j<n_Ye;j++) {
+	  for(size_t k=0;k<n_T;k++) {
+	    eos_tab_data[((i*n_Ye+j)*n_T+k)*12+q]=tg.get(i,j,k);
+	  }
+	}
+      }
+    }
+  }
+  hf.close();
+
+  eos_table_loaded=true;
+
+  cout << "Loaded table " << fname << " (" << n_nB << "x" << n_Ye
+       << "x" << n_T << " points). Point evaluations inside the "
+       << "grid are now interpolated." << endl;
+
+  return 0;
+}
+
+bool eos::table_interp_point(double nB, double Ye, double T_MeV,
+			     double *res) {
+
+  if (eos_table_loaded==false) return false;
+
+  size_t n_nB=eos_tab_nB.size();
+  size_t n_Ye=eos_tab_Ye.size();
+  size_t n_T=eos_tab_T.size();
+
+  if (nB<eos_tab_nB[0] || nB>eos_tab_nB[n_nB-1] ||
+      Ye<eos_tab_Ye[0] || Ye>eos_tab_Ye[n_Ye-1] ||
+      T_MeV<eos_tab_T[0] || T_MeV>eos_tab_T[n_T-1]) {
+    return false;
+  }
+
+  // Bracket each coordinate
+  auto bracket=[](const std::vector<double> &g, double x) {
+    size_t ix=std::lower_bound(g.begin(),g.end(),x)-g.begin();
+    if (ix>0) ix--;
+    if (ix>g.size()-2) ix=g.size()-2;
+    return ix;
+  };
+  size_t i0=bracket(eos_tab_nB,nB);
+  size_t j0=bracket(eos_tab_Ye,Ye);
+  size_t k0=bracket(eos_tab_T,T_MeV);
+
+  double wi=(nB-eos_tab_nB[i0])/(eos_tab_nB[i0+1]-eos_tab_nB[i0]);
+  double wj=(Ye-eos_tab_Ye[j0])/(eos_tab_Ye[j0+1]-eos_tab_Ye[j0]);
+  double wk=(T_MeV-eos_tab_T[k0])/(eos_tab_T[k0+1]-eos_tab_T[k0]);
+
+  // One set of trilinear weights applied to all twelve
+  // quantities from the fused point-major data
+  for(size_t q=0;q<12;q++) res[q]=0.0;
+  for(size_t di=0;di<2;di++) {
+    for(size_t dj=0;dj<2;dj++) {
+      for(size_t dk=0;dk<2;dk++) {
+	double w=(di==0 ? 1.0-wi : wi)*(dj==0 ? 1.0-wj : wj)*
+	  (dk==0 ? 1.0-wk : wk);
+	const double *pt=&eos_tab_data
+	  [(((i0+di)*n_Ye+(j0+dj))*n_T+(k0+dk))*12];
+	for(size_t q=0;q<12;q++) {
+	  res[q]+=w*pt[q];
+	}
+      }
+    }
+  }
+
+  return true;
+}
+
 int eos::point(std::vector<std::string> &sv, bool itive_com) {
 
   double nB=o2scl::stod(sv[1]);
   double Ye=o2scl::stod(sv[2]);
   double T=o2scl::stod(sv[3])/hc_mev_fm;
 
+  // Serve the point from the loaded table when possible; points
+  // outside the grid fall through to the direct evaluation
+  if (eos_table_loaded) {
+    double res[12];
+    if (table_interp_point(nB,Ye,T*hc_mev_fm,res)) {
+      static const char *qnames[12]={"Fint","F","Eint","E","Pint","P",
+				     "Sint","S","mun","mup","cs2","mue"};
+      cout << "Interpolated from the loaded table:" << endl;
+      cout.setf(ios::showpos);
+      for(size_t q=0;q<12;q++) {
+	cout << qnames[q] << "= " << res[q] << endl;
+      }
+      cout.unsetf(ios::showpos);
+      return 0;
+    }
+  }
+
   neutron.n=nB*(1.0-Ye);
   proton.n=nB*Ye;
   if (use_nrapr) {
@@ -3637,6 +6220,108 @@ int eos::point(std::vector<std::string> &sv, bool itive_com) {
   return 0;
 }
 
+int eos::points(std::vector<std::string> &sv, bool itive_com) {
+
+  if (sv.size()<3) {
+    cerr << "Command points needs an input and an output filename."
+	 << endl;
+    return 1;
+  }
+  string in_fname=sv[1];
+  string out_fname=sv[2];
+
+  // Read the point list, either from an HDF5 table with columns
+  // nB, Ye, and T, or from a whitespace-separated text file with
+  // one (nB,Ye,T) triple per line. Temperatures are in MeV in
+  // both cases, matching the point command.
+  vector<double> nB_list, Ye_list, T_list;
+  if (in_fname.size()>3 &&
+      in_fname.substr(in_fname.size()-3,3)==((string)".o2")) {
+    table_units<> tin;
+    hdf_file hf_in;
+    hf_in.open(in_fname);
+    hdf_input(hf_in,tin);
+    hf_in.close();
+    for(size_t i=0;i<tin.get_nlines();i++) {
+      nB_list.push_back(tin.get("nB",i));
+      Ye_list.push_back(tin.get("Ye",i));
+      T_list.push_back(tin.get("T",i));
+    }
+  } else {
+    ifstream fin(in_fname.c_str());
+    if (!fin.is_open()) {
+      cerr << "Could not open file " << in_fname
+	   << " in command points." << endl;
+      return 2;
+    }
+    double nBx, Yex, Tx;
+    while (fin >> nBx >> Yex >> Tx) {
+      nB_list.push_back(nBx);
+      Ye_list.push_back(Yex);
+      T_list.push_back(Tx);
+    }
+    fin.close();
+  }
+
+  size_t n_pts=nB_list.size();
+  if (verbose>0) {
+    cout << "Command points read " << n_pts << " points from "
+	 << in_fname << "." << endl;
+  }
+
+  // Evaluate in order of increasing baryon density so that the
+  // internal solvers warm-start from a neighboring point, but
+  // store the results by the original row index so that the
+  // output table matches the input ordering
+  vector<size_t> order(n_pts);
+  for(size_t i=0;i<n_pts;i++) order[i]=i;
+  std::sort(order.begin(),order.end(),
+	    [&nB_list](size_t a, size_t b) {
+	      return nB_list[a]<nB_list[b];
+	    });
+
+  vector<double> F_list(n_pts), P_list(n_pts), S_list(n_pts),
+    mun_list(n_pts), mup_list(n_pts);
+
+  for(size_t j=0;j<n_pts;j++) {
+    size_t i=order[j];
+    eval_point(nB_list[i],Ye_list[i],T_list[i],F_list[i],
+	       P_list[i],S_list[i],mun_list[i],mup_list[i]);
+    if (verbose>0 && j%1000==999) {
+      cout << "Command points finished " << j+1 << " of "
+	   << n_pts << " points." << endl;
+    }
+  }
+
+  table_units<> tout;
+  tout.line_of_names("nB Ye T F P S mun mup");
+  tout.set_unit("nB","1/fm^3");
+  tout.set_unit("T","MeV");
+  tout.set_unit("F","MeV");
+  tout.set_unit("P","MeV/fm^3");
+  tout.set_unit("mun","MeV");
+  tout.set_unit("mup","MeV");
+  for(size_t i=0;i<n_pts;i++) {
+    double line[8]={nB_list[i],Ye_list[i],T_list[i],F_list[i],
+		    P_list[i],S_list[i],mun_list[i],mup_list[i]};
+    tout.line_of_data(8,line);
+  }
+
+  hdf_file hf;
+  hf.open_or_create(out_fname);
+  hdf_output(hf,tout,"points");
+  if (stats.enabled) {
+    stats.hdf_out(hf);
+  }
+  hf.close();
+
+  if (stats.enabled) {
+    stats.report();
+  }
+
+  return 0;
+}
+
 int eos::test_eg(std::vector<std::string> &sv,
 		 bool itive_com) {
 
@@ -3747,7 +6432,7 @@ int eos::vir_fit(std::vector<std::string> &sv,
 
 void eos::setup_cli(o2scl::cli &cl) {
  
-  static const int nopt=13;
+  static const int nopt=18;
   o2scl::comm_option_s options[nopt]={
     {0,"test-deriv","Test the first derivatives of the free energy.",
      0,0,"","",new o2scl::comm_option_mfptr<eos>
@@ -3773,6 +6458,15 @@ void eos::setup_cli(o2scl::cli &cl) {
     {0,"point","Compute the EOS at one (n_B,Y_e,T) point.",0,3,"","",
      new o2scl::comm_option_mfptr<eos>
      (this,&eos::point),o2scl::cli::comm_option_both},
+    {0,"points","Compute the EOS at a list of (n_B,Y_e,T) points.",
+     2,2,"<input fname> <output fname>",
+     ((string)"Read (n_B,Y_e,T) triples (T in MeV) from an HDF5 ")+
+     "table with columns nB, Ye, and T, or from a whitespace-"
+     "separated text file, and write one output table in the "
+     "input row order. The points are evaluated in order of "
+     "increasing density internally.",
+     new o2scl::comm_option_mfptr<eos>
+     (this,&eos::points),o2scl::cli::comm_option_both},
     {0,"random","Generate a random EOS model.",0,0,"","",
      new o2scl::comm_option_mfptr<eos>
      (this,&eos::random),o2scl::cli::comm_option_both},
@@ -3790,7 +6484,37 @@ void eos::setup_cli(o2scl::cli &cl) {
      (this,&eos::test_eg),o2scl::cli::comm_option_both},
     {0,"vir-comp","Compare the virial and full EOS.",0,0,"","",
      new o2scl::comm_option_mfptr<eos>
-     (this,&eos::vir_comp),o2scl::cli::comm_option_both}
+     (this,&eos::vir_comp),o2scl::cli::comm_option_both},
+    {0,"table-beta","Construct a beta-equilibrium table.",
+     2,2,"<fname> <T (MeV)>",
+     ((string)"March the standard baryon density grid solving ")+
+     "for the neutrino-free equilibrium electron fraction at "
+     "fixed temperature, warm-starting each solve from the "
+     "previous densities, and write a table with columns nB, Ye, "
+     "F, P, cs2, and mue.",
+     new o2scl::comm_option_mfptr<eos>
+     (this,&eos::table_beta),o2scl::cli::comm_option_both},
+    {0,"load-table","Load a full table for interpolated points.",
+     1,1,"<fname>",
+     ((string)"Read the twelve tensors from a table-full output ")+
+     "file, after which point evaluations inside the table grid "
+     "are served by trilinear interpolation instead of the full "
+     "solver stack. Points outside the grid fall back to direct "
+     "evaluation.",
+     new o2scl::comm_option_mfptr<eos>
+     (this,&eos::load_table),o2scl::cli::comm_option_both},
+    {0,"bench","Time the hot kernels.",0,0,"",
+     ((string)"Report one line per kernel of the form 'bench ")+
+     "<name> <calls> <ns/call> <calls/sec>'. A random model with "
+     "a fixed seed is selected if none has been selected yet.",
+     new o2scl::comm_option_mfptr<eos>
+     (this,&eos::bench),o2scl::cli::comm_option_both},
+    {0,"ns-fit-gen","Precompute the NS fit for all rows.",0,0,"",
+     ((string)"Fit every row of the neutron star table and store the ")+
+     "results in data/ns_fit_cache.o2, which is then used by "
+     "select-model when use_ns_fit_cache is true.",
+     new o2scl::comm_option_mfptr<eos>
+     (this,&eos::ns_fit_gen),o2scl::cli::comm_option_both}
   };
   cl.set_comm_option_vec(nopt,options);
 
@@ -3832,5 +6556,88 @@ void eos::setup_cli(o2scl::cli &cl) {
   p_b_virial.help="Virial coefficient b (default 0.0)";
   cl.par_list.insert(make_pair("b_virial",&p_b_virial));
 
+  p_n_threads.i=&n_threads;
+  p_n_threads.help="Number of threads for table generation (default 1)";
+  cl.par_list.insert(make_pair("n_threads",&p_n_threads));
+
+  p_table_checkpoint.b=&table_checkpoint;
+  p_table_checkpoint.help=((string)"If true, checkpoint completed nB ")+
+    "slabs in table-full and restart from them (default true)";
+  cl.par_list.insert(make_pair("table_checkpoint",&p_table_checkpoint));
+
+  p_recover_points.b=&recover_points;
+  p_recover_points.help=((string)"If true, retry failed points in ")+
+    "table-full and interpolate those which still fail instead of "+
+    "aborting (default true)";
+  cl.par_list.insert(make_pair("recover_points",&p_recover_points));
+
+  p_skyrme_cache.b=&sk_cache.enabled;
+  p_skyrme_cache.help=((string)"If true, cache the Ye-independent ")+
+    "Skyrme evaluations in the free energy keyed on (nB,T) "+
+    "(default true)";
+  cl.par_list.insert(make_pair("skyrme_cache",&p_skyrme_cache));
+
+  p_cs2_numerical.b=&cs2_numerical;
+  p_cs2_numerical.help=((string)"If true, compute cs2 second ")+
+    "derivatives with separate adaptive numerical derivatives "+
+    "instead of the fixed-stencil fast path (default false)";
+  cl.par_list.insert(make_pair("cs2_numerical",&p_cs2_numerical));
+
+  p_use_lepton_table.b=&use_lepton_table;
+  p_use_lepton_table.help=((string)"If true, evaluate the electron ")+
+    "sector from a precomputed (ne,T) table instead of the "+
+    "relativistic Fermi integrals (default false)";
+  cl.par_list.insert(make_pair("use_lepton_table",&p_use_lepton_table));
+
+  p_flush_interval.i=&flush_interval;
+  p_flush_interval.help=((string)"Number of rows between ")+
+    "incremental output flushes in mcarlo-data and vir-comp "+
+    "(default 10)";
+  cl.par_list.insert(make_pair("flush_interval",&p_flush_interval));
+
+  p_use_ns_fit_cache.b=&use_ns_fit_cache;
+  p_use_ns_fit_cache.help=((string)"If true, use the precomputed ")+
+    "neutron star fit cache from ns-fit-gen when present "+
+    "(default true)";
+  cl.par_list.insert(make_pair("use_ns_fit_cache",&p_use_ns_fit_cache));
+
+  p_use_fit_splines.b=&use_fit_splines;
+  p_use_fit_splines.help=((string)"If true, evaluate the neutron ")+
+    "star fit functions from splines rather than the analytic "+
+    "expressions (default true)";
+  cl.par_list.insert(make_pair("use_fit_splines",&p_use_fit_splines));
+
+  p_collect_stats.b=&stats.enabled;
+  p_collect_stats.help=((string)"If true, collect call counts and ")+
+    "timings for the hot kernels and report them at the end of "+
+    "the table commands (default true)";
+  cl.par_list.insert(make_pair("collect_stats",&p_collect_stats));
+
+  p_adapt_tol.d=&adapt_tol;
+  p_adapt_tol.help=((string)"If positive, generate full tables ")+
+    "adaptively, evaluating only the coarse cells whose estimated "+
+    "interpolation error exceeds this tolerance and filling the "+
+    "rest by interpolation (default 0.0, serial only)";
+  cl.par_list.insert(make_pair("adapt_tol",&p_adapt_tol));
+
+  p_file_compr.i=&file_compr;
+  p_file_compr.help=((string)"Compression type for the full table ")+
+    "output files (default 0 for none, 1 for chunked gzip; "+
+    "requires an o2scl compiled with HDF5 compression support)";
+  cl.par_list.insert(make_pair("file_compr",&p_file_compr));
+
+  p_store_f32.b=&store_f32;
+  p_store_f32.help=((string)"If true, store cs2 and mue in the ")+
+    "full table output as flat single-precision arrays rather "+
+    "than double-precision tensors (default false)";
+  cl.par_list.insert(make_pair("store_f32",&p_store_f32));
+
+  p_fug_warm_start.b=&fug_warm_start;
+  p_fug_warm_start.help=((string)"If true, warm-start the virial ")+
+    "fugacity solves by polishing the previous solution, falling "+
+    "back to the closed-form solver when the polish fails "+
+    "(default true)";
+  cl.par_list.insert(make_pair("fug_warm_start",&p_fug_warm_start));
+
   return;
 }
@@ -18,7 +18,18 @@
 
   -------------------------------------------------------------------
 */
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
 #include <fstream>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 #ifndef NO_MPI
 #include <mpi.h>
@@ -47,15 +58,82 @@
 
 #include "virial_solver.h" 
 #include <o2scl/deriv_gsl.h>
+#include <o2scl/interp.h>
+#include <o2scl/table3d.h>
 #include <o2scl/deriv_cern.h>
 
 /** \brief An updated version of \ref o2scl::eos_crust_virial
     with a better fit for the virial coefficients
 */
 class eos_crust_virial_v2 : public o2scl::eos_crust_virial {
-  
+
+ protected:
+
+  /// True when the dense coefficient tables have been built
+  bool tables_built;
+
+  /// \name The dense coefficient tables over temperature
+  //@{
+  std::vector<double> T_tab, bn_tab, bpn_tab, dbndT_tab, dbpndT_tab;
+  //@}
+
+  /** \name Spline interpolators for the dense tables
+
+      These are held by shared pointer because \ref
+      o2scl::interp_vec is not copyable and \ref
+      eos::make_workers() copies the whole EOS object; the copies
+      share the (read-only) splines with the original.
+  */
+  //@{
+  std::shared_ptr<o2scl::interp_vec<std::vector<double> > >
+    itp_bn, itp_bpn, itp_dbndT, itp_dbpndT;
+  //@}
+
+  /// \name Coefficients precomputed on a registered grid
+  //@{
+  std::vector<double> T_reg, bn_reg, bpn_reg, dbndT_reg, dbpndT_reg;
+  //@}
+
+  /** \brief Return the index of \c T in the registered grid, or
+      -1 if it is not an exact grid point
+  */
+  int reg_index(double T) {
+    if (T_reg.size()==0) return -1;
+    std::vector<double>::const_iterator it=
+      std::lower_bound(T_reg.begin(),T_reg.end(),T);
+    if (it!=T_reg.end() && *it==T) {
+      return ((int)(it-T_reg.begin()));
+    }
+    return -1;
+  }
+
  public:
-  
+
+  /** \brief If true, evaluate the virial coefficients from the
+      precomputed tables instead of the analytic fit functions
+      (default true)
+  */
+  bool use_tables;
+
+  /** \brief Build the dense coefficient tables
+
+      This is called by the constructor and at the end of \ref
+      fit(), so the tables always correspond to the current
+      parameters. Temperatures outside the tabulated range fall
+      back to the analytic fit functions.
+  */
+  void build_tables();
+
+  /** \brief Register a temperature grid (in MeV) for exact-match
+      lookups
+
+      The four coefficients are precomputed at each grid point so
+      that table generation, which evaluates on the same fixed
+      temperature grid repeatedly, bypasses both the analytic
+      functions and the spline search.
+  */
+  void set_T_grid(const std::vector<double> &T_grid);
+
   /** \brief The neutron-neutron virial coefficient given the
       function parameters specified in \c par
    */
@@ -108,7 +186,523 @@ class eos_crust_virial_v2 : public o2scl::eos_crust_virial {
 
   virtual ~eos_crust_virial_v2() {}
   
-}; 
+};
+
+/** \brief A precomputed electron-positron EOS table over
+    \f$ (n_e,T) \f$
+
+    The electron sector depends only on the electron density and
+    the temperature, not on the hadronic model, so the
+    relativistic Fermi integrals can be tabulated once and shared
+    by every model in a scan. The table stores the logarithms of
+    the energy density, pressure, entropy density, and chemical
+    potential on a log-log \f$ (n_e,T) \f$ grid (all in
+    \f$ \mathrm{fm} \f$ units) and interpolates with the \ref
+    o2scl::table3d interpolation. The photon contribution is
+    analytic and is not tabulated.
+
+    If \ref cache_file is non-empty, \ref build() loads the table
+    from that HDF5 file when present and writes it there after
+    computing it otherwise.
+*/
+class lepton_table {
+
+ public:
+
+  /// True when the table is ready for interpolation
+  bool built;
+
+  /// Number of electron density points (default 320)
+  size_t n_ne;
+
+  /// Number of temperature points (default 200)
+  size_t n_T;
+
+  /** \brief HDF5 sidecar for the table (default
+      "lepton_eos.o2"; set to an empty string to disable)
+  */
+  std::string cache_file;
+
+  /// The table, with grids in \f$ \log_{10} \f$ units
+  o2scl::table3d tab;
+
+  lepton_table() {
+    built=false;
+    n_ne=320;
+    n_T=200;
+    cache_file="lepton_eos.o2";
+  }
+
+  /** \brief Build the table, or load it from \ref cache_file if
+      available
+  */
+  void build(o2scl::fermion &e, o2scl::fermion_rel &relf);
+
+  /** \brief Interpolate the electron EOS at \f$ (n_e,T) \f$
+
+      Returns false if the table is absent or the point is
+      outside the tabulated region, in which case the caller
+      should evaluate the Fermi integrals directly.
+  */
+  bool get(double ne, double T, double &ed, double &pr,
+	   double &en, double &mue) {
+    if (built==false) return false;
+    double lne=log10(ne), lT=log10(T);
+    if (lne<tab.get_x_data()[0] ||
+	lne>tab.get_x_data()[n_ne-1] ||
+	lT<tab.get_y_data()[0] ||
+	lT>tab.get_y_data()[n_T-1]) {
+      return false;
+    }
+    ed=pow(10.0,tab.interp(lne,lT,"log_ed"));
+    pr=pow(10.0,tab.interp(lne,lT,"log_pr"));
+    en=pow(10.0,tab.interp(lne,lT,"log_en"));
+    mue=pow(10.0,tab.interp(lne,lT,"log_mue"));
+    return true;
+  }
+
+  /** \brief Compare the table against the direct Fermi integrals
+      at off-grid points and return the maximum relative
+      deviation over all four quantities
+  */
+  double max_dev(o2scl::fermion &e, o2scl::fermion_rel &relf);
+
+};
+
+/** \brief A cache for the \f$ Y_e \f$-independent Skyrme
+    sub-evaluations in \ref eos::free_energy_density()
+
+    The "eqden" and "neut" evaluations of the finite-temperature
+    correction EOS depend only on the total baryon density and the
+    temperature, not on the electron fraction, so their fourteen
+    results are memoized keyed on the exact \f$ (n_B,T) \f$ pair.
+    Since \ref eos::table_full() iterates over \f$ Y_e \f$ in the
+    middle loop, this avoids recomputing these four Skyrme
+    evaluations for every \f$ Y_e \f$ grid point. Hit and miss
+    counters are kept so the savings can be verified.
+*/
+class skyrme_Tcorr_cache {
+
+ public:
+
+  /// The number of cached values per \f$ (n_B,T) \f$ pair
+  static const size_t nv=14;
+
+  /// If true, use the cache (default true)
+  bool enabled;
+
+  /// The number of cache hits
+  size_t n_hit;
+
+  /// The number of cache misses
+  size_t n_miss;
+
+  /** \brief Maximum number of entries before the cache is emptied
+      (default \f$ 10^6 \f$)
+
+      The numerical derivatives in \ref eos::cs2_fixYe() evaluate
+      the free energy at perturbed \f$ (n_B,T) \f$ values, so the
+      cache is bounded to keep those entries from accumulating
+      without limit.
+  */
+  size_t max_size;
+
+  skyrme_Tcorr_cache() {
+    enabled=true;
+    n_hit=0;
+    n_miss=0;
+    max_size=1000000;
+  }
+
+  /** \brief Look up the entry for \c (nB,T), returning true and
+      filling \c v on a hit
+  */
+  bool get(double nB, double T, double *v) {
+    if (enabled==false) return false;
+    std::map<std::pair<double,double>,
+	     std::vector<double> >::iterator it=
+      vals.find(std::make_pair(nB,T));
+    if (it==vals.end()) {
+      n_miss++;
+      return false;
+    }
+    for(size_t i=0;i<nv;i++) v[i]=it->second[i];
+    n_hit++;
+    return true;
+  }
+
+  /// Store the entry for \c (nB,T)
+  void store(double nB, double T, const double *v) {
+    if (enabled==false) return;
+    if (vals.size()>=max_size) vals.clear();
+    vals[std::make_pair(nB,T)]=std::vector<double>(v,v+nv);
+  }
+
+  /// Clear the cache and the counters
+  void clear() {
+    vals.clear();
+    n_hit=0;
+    n_miss=0;
+  }
+
+ protected:
+
+  /// The cached values, keyed on \f$ (n_B,T) \f$
+  std::map<std::pair<double,double>,std::vector<double> > vals;
+
+};
+
+/** \brief Dedicated writer thread for overlapping table I/O with
+    computation
+
+    On parallel file systems a checkpoint write can stall the
+    compute loop for several seconds. This class owns a single
+    background thread and a one-deep hand-off buffer: the compute
+    thread calls \ref push() with a completed block of data and
+    immediately continues filling the next one, blocking only if
+    the previous write has not yet finished (double buffering).
+    All writing is performed by the background thread through the
+    function given to \ref start(), so the underlying HDF5 file is
+    only ever touched by one thread at a time.
+*/
+class async_block_writer {
+
+ public:
+
+  async_block_writer();
+
+  ~async_block_writer();
+
+  /** \brief Start the writer thread
+
+      The function \c f is called from the writer thread with the
+      index and data of each block given to \ref push().
+  */
+  void start(std::function<void(size_t,const std::vector<double> &)> f);
+
+  /** \brief Hand block \c i off to the writer thread
+
+      Blocks only if the previous write has not yet finished.
+  */
+  void push(size_t i, const std::vector<double> &v);
+
+  /** \brief Wait for any pending write and join the writer thread
+
+      Called by the destructor if the thread is still running. The
+      file written by the thread may only be touched again after
+      this function returns.
+  */
+  void finish();
+
+ protected:
+
+  /// The writer thread main loop
+  void run();
+
+  /// The writer thread
+  std::thread th;
+
+  /// Protects the hand-off buffer and the flags
+  std::mutex mtx;
+
+  /// Signals hand-offs in both directions
+  std::condition_variable cv;
+
+  /// The function performing the writes
+  std::function<void(size_t,const std::vector<double> &)> write_fn;
+
+  /// True when a block is waiting for the writer thread
+  bool pending;
+
+  /// True when the writer thread should exit
+  bool stop;
+
+  /// True between \ref start() and \ref finish()
+  bool running;
+
+  /// Index of the pending block
+  size_t pend_i;
+
+  /// Data of the pending block
+  std::vector<double> pend_buf;
+
+};
+
+/** \brief Buffered append-mode writer for table rows
+
+    Rewriting the full accumulated table at every checkpoint makes
+    the I/O cost quadratic in the number of rows. This writer
+    keeps the output file open, buffers rows, and flushes them as
+    numbered flattened row-block datasets (<tt>block_0</tt>,
+    <tt>block_1</tt>, ...) together with the block count and the
+    column count, so each checkpoint writes only the new rows. The
+    block writes are performed by an \ref async_block_writer
+    thread, so appends overlap with the computation of the next
+    rows. The consolidated table in the usual format is written
+    once by \ref finish().
+*/
+class table_append_writer {
+
+ public:
+
+  /// Number of rows buffered between flushes (default 10)
+  size_t flush_interval;
+
+  table_append_writer() {
+    flush_interval=10;
+    n_cols=0;
+    n_rows=0;
+    n_blocks=0;
+    is_open=false;
+  }
+
+  /// Open the output file and reset the block counters
+  void open(std::string fname);
+
+  /** \brief Append one row, flushing if the buffer has reached
+      \ref flush_interval rows
+  */
+  void append(const std::vector<double> &row);
+
+  /// Flush any buffered rows as a new block dataset
+  void flush();
+
+  /** \brief Flush the remaining rows, write the consolidated
+      table \c t under \c name, and close the file
+  */
+  void finish(o2scl::table<> &t, std::string name);
+
+ protected:
+
+  /// The output file, which stays open between flushes
+  o2scl_hdf::hdf_file hf;
+
+  /// The background thread which performs the block writes
+  async_block_writer abw;
+
+  /// The buffered rows, flattened row-major
+  std::vector<double> buf;
+
+  /// Number of columns (fixed by the first row)
+  size_t n_cols;
+
+  /// Number of rows currently buffered
+  size_t n_rows;
+
+  /// Number of blocks written so far
+  size_t n_blocks;
+
+  /// True when \ref open() has been called
+  bool is_open;
+
+};
+
+/** \brief Memory-mapped cache for external supernova EOS tables
+
+    The supernova EOS tables compared in \ref eos::eos_sn() are
+    multi-gigabyte HDF5 files which are parsed into heap tensors on
+    every run. This class converts a loaded \ref o2scl::eos_sn_oo
+    object once into a flat binary sidecar file (the table filename
+    with ".bin" appended) containing the three grids and the
+    F, Fint, Xn, and Xalpha tensors, and then maps that file
+    read-only with mmap() on later runs. Repeated invocations and
+    concurrent processes on the same node share the kernel page
+    cache instead of keeping private copies, and attaching the
+    cache costs only the page faults actually touched by the
+    interpolation.
+*/
+class sn_table_cache {
+
+ public:
+
+  /// Indices for the cached quantities
+  //@{
+  static const size_t iF=0;
+  static const size_t iFint=1;
+  static const size_t iXn=2;
+  static const size_t iXalpha=3;
+  //@}
+
+  sn_table_cache() {
+    fd=-1;
+    map_ptr=0;
+    map_len=0;
+    is_mapped=false;
+  }
+
+  ~sn_table_cache() {
+    close();
+  }
+
+  /** \brief Map the sidecar file for table \c fname read-only
+
+      Returns true on success and false if the sidecar is absent
+      or has an unexpected format.
+  */
+  bool attach(std::string fname);
+
+  /** \brief Write the sidecar file for table \c fname from a
+      loaded \ref o2scl::eos_sn_oo object
+  */
+  void build(std::string fname, o2scl::eos_sn_oo &eso);
+
+  /** \brief Trilinear interpolation of quantity \c iq directly
+      from the mapped arrays
+  */
+  double interp_linear(size_t iq, double nB, double Ye, double T);
+
+  /// Unmap the sidecar file
+  void close();
+
+ protected:
+
+  /// File descriptor of the mapped sidecar
+  int fd;
+
+  /// Base address of the mapping
+  void *map_ptr;
+
+  /// Length of the mapping in bytes
+  size_t map_len;
+
+  /// True when a sidecar is currently mapped
+  bool is_mapped;
+
+  /// Grid sizes
+  size_t n_nB, n_Ye, n_T;
+
+  /// Pointers into the mapping for the grids
+  const double *nB_grid, *Ye_grid, *T_grid;
+
+  /// Pointers into the mapping for the four quantities
+  const double *data[4];
+
+};
+
+/** \brief Lightweight call-count and timing registry for the hot
+    kernels
+
+    Each instrumented kernel accumulates a call count and its
+    cumulative inclusive wall-clock time through \ref
+    eos_stats_timer objects placed at the kernel entry points.
+    Kernels nest (the Skyrme and fugacity kernels run inside the
+    free energy), so the times overlap and should be read as "time
+    spent inside this kernel" rather than as a partition. The
+    per-call overhead is two clock reads, so the registry can stay
+    enabled in production; setting \ref enabled to false reduces it
+    to two branches.
+*/
+class eos_stats {
+
+ public:
+
+  /// Number of instrumented kernels
+  static const size_t n_ker=6;
+
+  /// Kernel indices
+  //@{
+  /// free_energy_density()
+  static const size_t k_fed=0;
+  /// Virial fugacity solves
+  static const size_t k_fug=1;
+  /// cs2_fixYe()
+  static const size_t k_cs2=2;
+  /// Skyrme temperature-correction evaluations (cache misses)
+  static const size_t k_sk=3;
+  /// Electron EOS evaluations
+  static const size_t k_elec=4;
+  /// Full table points
+  static const size_t k_point=5;
+  //@}
+
+  /// If false, the scoped timers record nothing (default true)
+  bool enabled;
+
+  /// Call counts per kernel
+  size_t n_calls[n_ker];
+
+  /// Cumulative inclusive time per kernel in nanoseconds
+  double ns_tot[n_ker];
+
+  eos_stats() {
+    enabled=true;
+    clear();
+  }
+
+  /// Reset all counters
+  void clear() {
+    for(size_t k=0;k<n_ker;k++) {
+      n_calls[k]=0;
+      ns_tot[k]=0.0;
+    }
+  }
+
+  /// Record one call of kernel \c k taking \c ns nanoseconds
+  void add(size_t k, double ns) {
+    n_calls[k]++;
+    ns_tot[k]+=ns;
+  }
+
+  /// Merge the counters from a worker copy
+  void add_registry(const eos_stats &es) {
+    for(size_t k=0;k<n_ker;k++) {
+      n_calls[k]+=es.n_calls[k];
+      ns_tot[k]+=es.ns_tot[k];
+    }
+  }
+
+  /// The name of kernel \c k
+  static const char *name(size_t k);
+
+  /** \brief Print one line per kernel of the form
+      <tt>stats <name> <calls> <ns/call> <total_s></tt>
+  */
+  void report() const;
+
+  /** \brief Store the counters in an open HDF5 file as the
+      vectors <tt>stats_calls</tt> and <tt>stats_ns</tt> (in
+      kernel index order)
+  */
+  void hdf_out(o2scl_hdf::hdf_file &hf) const;
+
+};
+
+/** \brief Scoped timer which records into an \ref eos_stats
+    registry on destruction
+*/
+class eos_stats_timer {
+
+ public:
+
+  eos_stats_timer(eos_stats &es, size_t k) {
+    esp=&es;
+    ker=k;
+    if (esp->enabled) {
+      t0=std::chrono::high_resolution_clock::now();
+    }
+  }
+
+  ~eos_stats_timer() {
+    if (esp->enabled) {
+      std::chrono::high_resolution_clock::time_point t1=
+	std::chrono::high_resolution_clock::now();
+      esp->add(ker,((double)std::chrono::duration_cast
+		    <std::chrono::nanoseconds>(t1-t0).count()));
+    }
+  }
+
+ protected:
+
+  /// The target registry
+  eos_stats *esp;
+
+  /// The kernel index
+  size_t ker;
+
+  /// The time at construction
+  std::chrono::high_resolution_clock::time_point t0;
+
+};
 
 /** \brief Phenomenological EOS for homogeneous nucleonic matter
  */
@@ -164,23 +758,48 @@ class eos {
     (o2scl::fermion &n, o2scl::fermion &p, double T,
      o2scl::thermo &th);
 
-  /** \brief Compute the free energy density using the virial 
+  /** \brief Compute the free energy density using the virial
       expansion including derivative information
   */
   virtual double free_energy_density_virial
     (o2scl::fermion &n, o2scl::fermion &p, double T,
      o2scl::thermo &th, double &dmundnn, double &dmundpn,
      double &dmupdnn, double &dmupdpn, double &dmundT,
-     double &dmupdT);    
+     double &dmupdT);
+
+  /** \brief Compute the free energy density using the virial
+      expansion without any derivative information
+
+      This stops after the fugacity solve and the free-energy,
+      pressure, and entropy assembly, skipping the three linear
+      solves for the chemical potential derivatives, which
+      dominate the per-point cost in virial-dominated sweeps. The
+      state required for the derivatives is stored in \ref acl,
+      so they can still be computed afterwards on demand with
+      \ref virial_deriv_mu().
+  */
+  virtual double free_energy_density_virial_base
+    (o2scl::fermion &n, o2scl::fermion &p, double T,
+     o2scl::thermo &th);
+
+  /** \brief Compute the chemical potential derivatives for the
+      most recent virial evaluation
 
-  /** \brief Compute the free energy density using the virial 
+      Uses the state stored in \ref acl by \ref
+      free_energy_density_virial_base(), so it must be called
+      before any other virial evaluation overwrites that state.
+  */
+  virtual void virial_deriv_mu
+    (double &dmundnn, double &dmundpn, double &dmupdnn,
+     double &dmupdpn, double &dmundT, double &dmupdT);
+
+  /** \brief Compute the free energy density using the virial
       expansion
   */
   virtual double free_energy_density_virial
     (o2scl::fermion &n, o2scl::fermion &p, double T,
      o2scl::thermo &th) {
-    double x1, x2, x3, x4, x5, x6;
-    return free_energy_density_virial(n,p,T,th,x1,x2,x3,x4,x5,x6);
+    return free_energy_density_virial_base(n,p,T,th);
   }
   
   /** \brief Alternate form of \ref free_energy_density() for
@@ -192,7 +811,17 @@ class eos {
 				 double nn, double np, double T,
 				 o2scl::thermo &th);
 
-  /** \brief Alternate form of \ref free_energy_density() 
+  /** \brief Compute the electron-positron EOS at
+      \f$ (n_e,T) \f$, storing the result in \ref electron
+
+      When \ref use_lepton_table is true the result comes from
+      the interpolated \ref lep_tab (built on first use), falling
+      back to the direct Fermi integrals outside the tabulated
+      region.
+  */
+  void compute_electron(double ne, double T);
+
+  /** \brief Alternate form of \ref free_energy_density()
       which includes electrons, positrons, and photons.
   */
   double free_energy_density_ep(double nn, double np, double T);
@@ -209,13 +838,43 @@ class eos {
   double ed(o2scl::fermion &n, o2scl::fermion &p,
 	    double nn, double np, double T, o2scl::thermo &th);
 
-  /** \brief Compute the squared speed of sound at 
+  /** \brief Compute the total free-energy derivatives and the
+      entropy in one evaluation
+
+      This function evaluates the hadronic free energy, the
+      electrons, and the photons once at \f$ (n_n,n_p,T) \f$ and
+      returns the total neutron and proton free-energy
+      derivatives, the total entropy density, and the total
+      energy density (including the nucleon rest masses), so that
+      the second derivatives required by \ref cs2_fixYe() can be
+      built from a fixed difference stencil instead of separate
+      adaptive derivatives.
+  */
+  void mu_s_total(o2scl::fermion &n, o2scl::fermion &p,
+		  double nn, double pn, double T, o2scl::thermo &th,
+		  double &mun_tot, double &mup_tot, double &s_tot,
+		  double &ed_tot);
+
+  /** \brief Compute the squared speed of sound at
       fixed \f$ Y_e \f$
+
+      If \ref cs2_numerical is false, the nine second derivatives
+      are computed from a fixed central-difference stencil using
+      \ref mu_s_total(), which requires seven point evaluations.
+      Otherwise they are computed with separate adaptive numerical
+      derivatives as before, which is several times slower but
+      serves as a cross-check.
   */
   double cs2_fixYe(o2scl::fermion &n, o2scl::fermion &p, double T,
 		   o2scl::thermo &th);
 
-  /** \brief Compute the squared speed of sound at 
+  /** \brief Compute the squared speed of sound at fixed
+      \f$ Y_e \f$ using adaptive numerical derivatives
+  */
+  double cs2_fixYe_numerical(o2scl::fermion &n, o2scl::fermion &p,
+			     double T, o2scl::thermo &th);
+
+  /** \brief Compute the squared speed of sound at
       fixed \f$ Y_e \f$, alternate version
   */
   double cs2_fixYe_alt(o2scl::fermion &n, o2scl::fermion &p, double T,
@@ -235,7 +894,21 @@ class eos {
 
   /// The table which stores the Skyrme fits
   o2scl::table_units<> UNEDF_tab;
-  
+
+  /** \brief True once the neutron star and Skyrme data tables
+      have been read (default false)
+  */
+  bool data_tables_loaded;
+
+  /** \brief Read the neutron star and Skyrme data tables if they
+      have not yet been read
+
+      Loading is deferred to the first call from model selection
+      so that commands which never select a model do not pay the
+      HDF5 parse at startup.
+  */
+  void load_data_tables();
+
   /** \brief If true, a model has been selected (default false)
    */
   bool model_selected;
@@ -332,6 +1005,55 @@ class eos {
       for the nucleons. 
   */
   double mu_fit(double nb);
+
+  /// If true, the fit function splines have been constructed
+  bool fit_splines_built;
+
+  /// Lower limit of the fit function spline grid
+  double fit_spline_nb_lo;
+
+  /// Upper limit of the fit function spline grid
+  double fit_spline_nb_hi;
+
+  /// Baryon density grid for the fit function splines
+  std::vector<double> fit_nb_tab;
+
+  /// Tabulated values of \ref ed_fit()
+  std::vector<double> ed_fit_tab;
+
+  /// Tabulated values of \ref mu_fit()
+  std::vector<double> mu_fit_tab;
+
+  /// Tabulated values of \ref dmudn_fit()
+  std::vector<double> dmudn_fit_tab;
+
+  /// Tabulated values of \ref cs2_fit()
+  std::vector<double> cs2_fit_tab;
+
+  /** \brief Spline for \ref ed_fit()
+
+      Copies of this class share the splines, which is safe
+      because they are read-only after \ref build_fit_splines() .
+  */
+  std::shared_ptr<o2scl::interp_vec<std::vector<double> > > itp_ed_fit;
+
+  /// Spline for \ref mu_fit()
+  std::shared_ptr<o2scl::interp_vec<std::vector<double> > > itp_mu_fit;
+
+  /// Spline for \ref dmudn_fit()
+  std::shared_ptr<o2scl::interp_vec<std::vector<double> > > itp_dmudn_fit;
+
+  /// Spline for \ref cs2_fit()
+  std::shared_ptr<o2scl::interp_vec<std::vector<double> > > itp_cs2_fit;
+
+  /** \brief Construct splines for the four fit functions from the
+      current values of \ref ns_fit_parms
+
+      This function is called at the end of \ref ns_fit() so that
+      the high-density loops in \ref new_ns_eos() and \ref
+      min_max_cs2() avoid re-evaluating the fit polynomials.
+  */
+  void build_fit_splines();
   //@}
 
   /// \name Parameter objects
@@ -345,6 +1067,20 @@ class eos {
   o2scl::cli::parameter_bool p_use_nrapr;
   o2scl::cli::parameter_double p_a_virial;
   o2scl::cli::parameter_double p_b_virial;
+  o2scl::cli::parameter_int p_n_threads;
+  o2scl::cli::parameter_bool p_table_checkpoint;
+  o2scl::cli::parameter_bool p_recover_points;
+  o2scl::cli::parameter_bool p_skyrme_cache;
+  o2scl::cli::parameter_bool p_cs2_numerical;
+  o2scl::cli::parameter_bool p_use_lepton_table;
+  o2scl::cli::parameter_int p_flush_interval;
+  o2scl::cli::parameter_bool p_use_ns_fit_cache;
+  o2scl::cli::parameter_bool p_use_fit_splines;
+  o2scl::cli::parameter_bool p_collect_stats;
+  o2scl::cli::parameter_double p_adapt_tol;
+  o2scl::cli::parameter_int p_file_compr;
+  o2scl::cli::parameter_bool p_store_f32;
+  o2scl::cli::parameter_bool p_fug_warm_start;
   //@}
   
   /// \name Other EOS functions [protected]
@@ -393,6 +1129,128 @@ class eos {
 		      double eos_L_loc, double eos_S_loc, double phi_loc);
   //@}
 
+  /// \name Table generation [protected]
+  //@{
+  /** \brief Compute the twelve table quantities at one
+      \f$ (n_B,Y_e,T) \f$ point
+
+      The results are stored in \c res in the order Fint, F, Eint,
+      E, Pint, P, Sint, S, mun, mup, cs2, and mue. The temperature
+      \c T_MeV should be in MeV.
+
+      If \ref recover_points is true and the point fails even
+      after the retries, all twelve entries of \c res are set to
+      NaN and a non-zero value is returned so that \ref
+      table_full() can fill the cell by interpolation afterwards.
+  */
+  int table_full_point(double nB, double Ye, double T_MeV,
+		       o2scl::eos_sn_oo &eso, double *res);
+
+  /** \brief A single attempt at computing the twelve table
+      quantities at one \f$ (n_B,Y_e,T) \f$ point
+
+      This function performs the non-finite checks and returns a
+      non-zero value on failure when \ref recover_points is true.
+      When \ref recover_points is false it calls <tt>exit(-1)</tt>
+      instead, as \ref table_full() originally did.
+  */
+  int table_full_point_attempt(double nB, double Ye, double T_MeV,
+			       o2scl::eos_sn_oo &eso, double *res);
+
+  /** \brief Compute one slab of the full table at fixed baryon
+      density
+
+      The slab is stored point-major, i.e. the value of quantity
+      \c q at \f$ (Y_e,T) \f$ index \f$ (j,k) \f$ is
+      <tt>slab[(j*n_T+k)*12+q]</tt>, so each evaluated point
+      writes its twelve results contiguously instead of
+      scattering them across twelve strided arrays. The
+      per-quantity tensor layout of the output file is produced
+      only at write time. If \ref n_threads
+      is larger than 1, the \f$ (Y_e,T) \f$ plane is distributed
+      over the worker objects in \c workers, which must have been
+      created by \ref make_workers().
+  */
+  void table_full_slab(size_t i, const std::vector<double> &nB_grid,
+		       const std::vector<double> &Ye_grid,
+		       const std::vector<double> &T_grid,
+		       std::vector<std::shared_ptr<eos> > &workers,
+		       std::vector<double> &slab);
+
+  /** \brief Create independent copies of this object for
+      threaded evaluation
+
+      Each worker carries its own copies of the neutron and proton
+      fermion objects, the thermo objects, the virial solver and
+      the Skyrme objects, so point evaluations in distinct workers
+      are independent of each other.
+  */
+  void make_workers(std::vector<std::shared_ptr<eos> > &workers,
+		    size_t n);
+
+  /** \brief Generate the full table adaptively
+
+      Called by \ref table_full() when \ref adapt_tol is positive.
+      A coarse sub-grid (every fourth point in each direction) is
+      evaluated first, the local interpolation error of each
+      coarse cell is estimated by comparing a trilinear
+      interpolation of F and cs2 against a true evaluation at the
+      cell midpoint, and only cells above the tolerance are
+      evaluated densely. The remaining points are filled by
+      trilinear interpolation, so the output file has the same
+      dense-grid format as the standard mode. This mode currently
+      runs serially on a single rank.
+  */
+  int table_full_adaptive(std::string fname);
+
+  /** \brief Write tensor \c t to \c hf as a flat single-precision
+      array named \c name
+
+      Used by the table commands when \ref store_f32 is true. The
+      data is stored in the same (nB,Ye,T) row-major order as the
+      tensor, and the grids are already stored at the top level of
+      the file.
+  */
+  void tensor_out_f32(o2scl_hdf::hdf_file &hf,
+		      o2scl::tensor_grid3<> &t, std::string name);
+  //@}
+
+  /// \name Table-backed evaluation [protected]
+  //@{
+  /// True when \ref load_table() has read a table
+  bool eos_table_loaded;
+
+  /** \brief The loaded table data, fused point-major
+
+      The value of quantity \c q (in the \ref table_full_point()
+      order) at grid index \f$ (i,j,k) \f$ is stored at
+      <tt>[((i*n_Ye+j)*n_T+k)*12+q]</tt>, so a multi-quantity
+      lookup at one point touches one cache neighborhood instead
+      of twelve separate tensors.
+  */
+  std::vector<double> eos_tab_data;
+
+  /// The grids of the loaded table
+  //@{
+  std::vector<double> eos_tab_nB;
+  std::vector<double> eos_tab_Ye;
+  std::vector<double> eos_tab_T;
+  //@}
+
+  /** \brief Interpolate all twelve quantities from the loaded
+      table
+
+      Returns true and fills \c res (in the \ref
+      table_full_point() order) if a table has been loaded and
+      \f$ (n_B,Y_e,T) \f$ lies inside its grid, and false
+      otherwise. All twelve quantities are computed by trilinear
+      interpolation with one set of weights from the fused
+      point-major data.
+  */
+  bool table_interp_point(double nB, double Ye, double T_MeV,
+			  double *res);
+  //@}
+
   /// \name Particle objects [protected]
   //@{
   /** \brief Electron/positron
@@ -428,10 +1286,31 @@ class eos {
   /// The virial equation solver
   virial_solver_new acl;
 
+  /** \brief If true, the fugacity guesses below are usable
+
+      Set by \ref free_energy_density_virial() after each solve.
+      In the table loops successive points vary smoothly, so the
+      previous point's fugacities polish to the solution by a few
+      Newton steps instead of a closed-form quartic solve, which
+      is where most of the fugacity-solver time goes.
+  */
+  bool fug_guess_valid;
+
+  /// Fugacity guesses from the previous solve
+  //@{
+  double fug_zn_guess;
+  double fug_zp_guess;
+  //@}
+
   /** \brief Object for computing electron/positron thermodynamic integrals
    */
   o2scl::fermion_rel relf;
 
+  /** \brief Precomputed electron-positron EOS table, used when
+      \ref use_lepton_table is true
+  */
+  lepton_table lep_tab;
+
   /// Thermodynamic quantities
   o2scl::thermo th2;
   
@@ -447,6 +1326,34 @@ class eos {
   /// Pointer to EOS for finite-temperature corrections
   o2scl::eos_had_temp_eden_base *eos_Tcorr;
 
+  /** \brief Cache for the \f$ Y_e \f$-independent
+      finite-temperature correction evaluations
+  */
+  skyrme_Tcorr_cache sk_cache;
+
+  /// \name Neutron star fit cache [protected]
+  //@{
+  /// True when the fit cache has been loaded from the sidecar
+  bool ns_cache_loaded;
+
+  /// True once loading the sidecar has been attempted
+  bool ns_cache_checked;
+
+  /// The cached fit parameters, five per row of \ref nstar_tab
+  std::vector<double> ns_cache_parms;
+
+  /// The cached fit quality per row
+  std::vector<double> ns_cache_chi2;
+
+  /// The cached maximum baryon density per row
+  std::vector<double> ns_cache_nb_max;
+
+  /** \brief Load the neutron star fit cache from its sidecar
+      file if present
+  */
+  void load_ns_fit_cache();
+  //@}
+
   /// The virial EOS
   eos_crust_virial_v2 ecv;
   //@}
@@ -522,6 +1429,105 @@ class eos {
       (default true)
   */
   bool select_cs2_test;
+
+  /** \brief Number of threads for table generation (default 1)
+   */
+  int n_threads;
+
+  /** \brief If true, checkpoint completed nB slabs in \ref
+      table_full() and restart from them (default true)
+  */
+  bool table_checkpoint;
+
+  /** \brief If true, retry failed points in \ref table_full()
+      and interpolate those which still fail instead of aborting
+      (default true)
+  */
+  bool recover_points;
+
+  /** \brief If true, compute the second derivatives in \ref
+      cs2_fixYe() with separate adaptive numerical derivatives
+      instead of the fixed-stencil fast path (default false)
+  */
+  bool cs2_numerical;
+
+  /** \brief If true, evaluate the electron sector from the
+      precomputed \ref lepton_table instead of the relativistic
+      Fermi integrals (default false)
+  */
+  bool use_lepton_table;
+
+  /** \brief Number of rows between incremental output flushes in
+      \ref mcarlo_data() and \ref vir_comp() (default 10)
+  */
+  int flush_interval;
+
+  /** \brief If true, use the precomputed neutron star fit cache
+      (generated with the ns-fit-gen command) when it is present
+      (default true)
+  */
+  bool use_ns_fit_cache;
+
+  /** \brief If true, evaluate the neutron star fit functions from
+      splines rather than the analytic expressions (default true)
+
+      Setting this to false restores the direct evaluation, which
+      is useful for validating the splines.
+  */
+  bool use_fit_splines;
+
+  /** \brief Call-count and timing registry for the hot kernels
+
+      Worker copies accumulate into their own registries, which
+      are merged into the parent's at the end of the threaded
+      commands. The \c collect_stats parameter controls \ref
+      eos_stats::enabled .
+  */
+  eos_stats stats;
+
+  /** \brief Tolerance for adaptive table generation (default 0.0)
+
+      If positive, \ref table_full() estimates the local
+      interpolation error of F and cs2 on a coarse sub-grid and
+      only evaluates cells above this tolerance densely, filling
+      the rest by interpolation.
+  */
+  double adapt_tol;
+
+  /** \brief Compression type for table output (default 0)
+
+      Passed to \c hdf_file::compr_type before the full tables are
+      written, so a value of 1 selects chunked datasets with gzip
+      compression. Compression requires an o2scl installation
+      compiled with \c O2SCL_HDF5_COMP and is otherwise silently
+      ignored.
+  */
+  int file_compr;
+
+  /** \brief If true, store cs2 and mue in single precision
+      (default false)
+
+      These two quantities have uncertainties far above the float
+      truncation error, so storing them as flat single-precision
+      arrays (rather than \ref o2scl::tensor_grid3 objects) roughly
+      halves their size on disk. The output file records this
+      choice in the \c f32_data flag.
+  */
+  bool store_f32;
+
+  /** \brief If true, warm-start the fugacity solves (default true)
+
+      Each fugacity solve in \ref free_energy_density_virial()
+      first polishes the previous solution by Newton iteration on
+      the original two-dimensional system, which converges in a
+      few steps when successive points vary smoothly (as in the
+      table loops and the cs2 stencils). Points where the polish
+      fails fall back to the closed-form quartic solver, so the
+      result is identical to within the \f$ 10^{-10} \f$ relative
+      polishing tolerance. The batch counters in \ref
+      virial_solver_new record how many points took each path.
+  */
+  bool fug_warm_start;
   //@}
 
   /// \name Command-line interface functions [public]
@@ -540,10 +1546,31 @@ class eos {
    */
   int pns_eos(std::vector<std::string> &sv, bool itive_com);
   
-  /** \brief Construct a full table 
-   */
+  /** \brief Construct a full table
+
+      The evaluation loop works one point-major nB slab at a time,
+      but all twelve per-quantity tensors stay resident for the
+      whole run: \ref o2scl_hdf::hdf_output() writes a \ref
+      o2scl::tensor_grid3 only as a complete object, so streaming
+      completed slabs into the output file is not possible through
+      the o2scl interface, and the NaN recovery post-pass also
+      needs random access across slabs. The checkpoint sidecar
+      therefore provides restart, not a lower memory ceiling.
+  */
   int table_full(std::vector<std::string> &sv, bool itive_com);
 
+  /** \brief Construct a beta-equilibrium table at fixed temperature
+
+      Marches the standard baryon density grid from high to low
+      density, solving \ref solve_Ye() at \f$ \mu_L=0 \f$ for the
+      equilibrium electron fraction at each point. Each solve is
+      warm-started by linearly extrapolating the equilibrium
+      \f$ Y_e \f$ from the previous two densities, so the whole
+      curve costs one solve per point instead of a bisection over
+      fixed-\f$ Y_e \f$ tables.
+  */
+  int table_beta(std::vector<std::string> &sv, bool itive_com);
+
   /** \brief Test the code
    */
   int test_deriv(std::vector<std::string> &sv, bool itive_com);
@@ -561,6 +1588,22 @@ class eos {
    */
   int point(std::vector<std::string> &sv, bool itive_com);
 
+  /** \brief Evaluate the EOS at a list of points read from a file
+   */
+  int points(std::vector<std::string> &sv, bool itive_com);
+
+  /** \brief Load a full table for interpolated point evaluation
+
+      Reads the twelve tensors from a \ref table_full() output
+      file into the fused point-major evaluator, after which the
+      point and points commands (and \ref eval_point() and \ref
+      cs2_point()) serve queries inside the table grid by
+      trilinear interpolation in \f$ (n_B,Y_e,T) \f$ instead of
+      re-running the solver stack. Points outside the grid fall
+      back to direct evaluation.
+  */
+  int load_table(std::vector<std::string> &sv, bool itive_com);
+
   /** \brief Select a random model
    */
   int random(std::vector<std::string> &sv, bool itive_com);
@@ -573,6 +1616,21 @@ class eos {
    */
   int mcarlo_data(std::vector<std::string> &sv, bool itive_com);
 
+  /** \brief Fit every row of the neutron star table and store
+      the results in the fit cache sidecar file
+  */
+  int ns_fit_gen(std::vector<std::string> &sv, bool itive_com);
+
+  /** \brief Time the hot kernels and report ns/call and calls/sec
+
+      Each kernel is reported on one line of the form
+      <tt>bench <name> <calls> <ns/call> <calls/sec></tt>
+      so that results can be collected across commits. If no model
+      has been selected, a random model is chosen with a fixed
+      seed first.
+  */
+  int bench(std::vector<std::string> &sv, bool itive_com);
+
   /** \brief Perform the virial fit
    */
   int vir_fit(std::vector<std::string> &sv, bool itive_com);
@@ -587,6 +1645,62 @@ class eos {
   int eos_sn(std::vector<std::string> &sv, bool itive_com);
   //@}
 
+  /// \name Library interface [public]
+  //@{
+  /** \brief Select a model from its seven parameters
+
+      This is a thin wrapper around \ref select_internal() for
+      library callers (see \ref eos_api.h) and returns the same
+      failure codes.
+  */
+  int select_params(int i_ns_loc, int i_skyrme_loc,
+		    double qmc_alpha_loc, double qmc_a_loc,
+		    double eos_L_loc, double eos_S_loc, double phi_loc);
+
+  /** \brief Screen a batch of candidate models
+
+      Each entry of \c cands contains the seven parameters in the
+      same order as \ref select_internal(): i_ns, i_skyrme,
+      qmc_alpha, qmc_a, eos_L, eos_S, and phi. On return, \c codes
+      contains zero for candidates which pass all of the checks
+      and otherwise the failure code from \ref select_internal().
+      The cheap analytic cuts are applied to all candidates first,
+      and the survivors are evaluated by \ref n_threads worker
+      objects, so this object's currently selected model is not
+      modified.
+  */
+  int screen_models(const std::vector<std::vector<double> > &cands,
+		    std::vector<int> &codes);
+
+  /** \brief Create an independent copy of this object
+
+      The copy shares the currently selected model but has its own
+      evaluation state, so distinct copies can be evaluated
+      concurrently from different threads.
+  */
+  std::shared_ptr<eos> clone();
+
+  /** \brief Evaluate the EOS at one \f$ (n_B,Y_e,T) \f$ point
+
+      The temperature \c T_MeV is specified in MeV. On return,
+      \c F is the total free energy per baryon (including the
+      nucleon rest masses) in MeV, \c P is the total pressure in
+      \f$ \mathrm{MeV}/\mathrm{fm}^3 \f$, \c S is the entropy per
+      baryon, and \c mun and \c mup are the neutron and proton
+      chemical potentials (including the rest masses and, for the
+      protons, the electron contribution) in MeV. Electrons,
+      positrons, and photons are included.
+  */
+  int eval_point(double nB, double Ye, double T_MeV,
+		 double &F, double &P, double &S,
+		 double &mun, double &mup);
+
+  /** \brief Compute the squared speed of sound at one
+      \f$ (n_B,Y_e,T) \f$ point (\c T_MeV in MeV)
+  */
+  int cs2_point(double nB, double Ye, double T_MeV, double &cs2);
+  //@}
+
   /// \name Miscellaneous functions [public]
   //@{
   /** \brief Solve for fixed entropy per baryon and fixed
@@ -0,0 +1,102 @@
+/*
+  -------------------------------------------------------------------
+
+  Copyright (C) 2018-2019, Xingfu Du and Andrew W. Steiner
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+  -------------------------------------------------------------------
+*/
+#include "eos_api.h"
+
+#include "eos.h"
+
+using namespace std;
+
+/* The clone() member function returns a shared pointer, so each
+   handle wraps the shared pointer rather than the eos object
+   itself to keep the ownership conventions uniform.
+*/
+struct eos_api_handle {
+  std::shared_ptr<eos> ep;
+};
+
+extern "C" {
+
+eos_handle eos_create(void) {
+  try {
+    eos_api_handle *hp=new eos_api_handle;
+    hp->ep=std::shared_ptr<eos>(new eos);
+    return (eos_handle)hp;
+  } catch (...) {
+    return 0;
+  }
+}
+
+eos_handle eos_clone(eos_handle h) {
+  if (h==0) return 0;
+  try {
+    eos_api_handle *hp=(eos_api_handle *)h;
+    eos_api_handle *hp2=new eos_api_handle;
+    hp2->ep=hp->ep->clone();
+    return (eos_handle)hp2;
+  } catch (...) {
+    return 0;
+  }
+}
+
+int eos_select(eos_handle h, int i_ns, int i_skyrme,
+	       double qmc_alpha, double qmc_a, double eos_L,
+	       double eos_S, double phi) {
+  if (h==0) return -1;
+  try {
+    eos_api_handle *hp=(eos_api_handle *)h;
+    return hp->ep->select_params(i_ns,i_skyrme,qmc_alpha,qmc_a,
+				 eos_L,eos_S,phi);
+  } catch (...) {
+    return -1;
+  }
+}
+
+int eos_eval(eos_handle h, double nB, double Ye, double T,
+	     double *F, double *P, double *S,
+	     double *mun, double *mup) {
+  if (h==0) return -1;
+  try {
+    eos_api_handle *hp=(eos_api_handle *)h;
+    return hp->ep->eval_point(nB,Ye,T,*F,*P,*S,*mun,*mup);
+  } catch (...) {
+    return -1;
+  }
+}
+
+int eos_cs2(eos_handle h, double nB, double Ye, double T,
+	    double *cs2) {
+  if (h==0) return -1;
+  try {
+    eos_api_handle *hp=(eos_api_handle *)h;
+    return hp->ep->cs2_point(nB,Ye,T,*cs2);
+  } catch (...) {
+    return -1;
+  }
+}
+
+void eos_destroy(eos_handle h) {
+  if (h==0) return;
+  eos_api_handle *hp=(eos_api_handle *)h;
+  delete hp;
+  return;
+}
+
+}
@@ -0,0 +1,98 @@
+/*
+  -------------------------------------------------------------------
+
+  Copyright (C) 2018-2019, Xingfu Du and Andrew W. Steiner
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful, but
+  WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+  General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program. If not, see <http://www.gnu.org/licenses/>.
+
+  -------------------------------------------------------------------
+*/
+/** \file eos_api.h
+    \brief C interface for the libeos shared library
+
+    This header exposes the \ref eos class to C and Fortran callers
+    through opaque handles so that client codes can evaluate the EOS
+    in-process instead of spawning the command-line interface for
+    every point. A handle is not internally locked: create one
+    handle per thread, either with eos_create() or by cloning a
+    handle with a selected model with eos_clone().
+
+    All functions which return int use zero for success. The
+    evaluation functions return the failure code from the
+    corresponding member function, or -1 if an exception was
+    thrown.
+*/
+#ifndef EOS_API_H
+#define EOS_API_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \brief Opaque handle to an \ref eos object
+ */
+typedef void *eos_handle;
+
+/** \brief Allocate a new EOS object
+
+    Returns zero on failure. The handle must be freed with
+    eos_destroy().
+*/
+eos_handle eos_create(void);
+
+/** \brief Allocate a copy of \c h, sharing its selected model
+
+    Returns zero on failure. The copy has its own evaluation state,
+    so distinct handles can be evaluated concurrently.
+*/
+eos_handle eos_clone(eos_handle h);
+
+/** \brief Select a model from its seven parameters
+
+    The parameters are in the same order as the select-model
+    command. Returns zero if the model passes all of the checks
+    and otherwise the failure code.
+*/
+int eos_select(eos_handle h, int i_ns, int i_skyrme,
+	       double qmc_alpha, double qmc_a, double eos_L,
+	       double eos_S, double phi);
+
+/** \brief Evaluate the EOS at one (nB,Ye,T) point
+
+    The baryon density \c nB is in 1/fm^3 and the temperature \c T
+    is in MeV. On success *F is the total free energy per baryon
+    (including the nucleon rest masses) in MeV, *P is the total
+    pressure in MeV/fm^3, *S is the entropy per baryon, and *mun
+    and *mup are the neutron and proton chemical potentials in MeV.
+    Electrons, positrons, and photons are included.
+*/
+int eos_eval(eos_handle h, double nB, double Ye, double T,
+	     double *F, double *P, double *S,
+	     double *mun, double *mup);
+
+/** \brief Compute the squared speed of sound at one (nB,Ye,T)
+    point (\c T in MeV)
+*/
+int eos_cs2(eos_handle h, double nB, double Ye, double T,
+	    double *cs2);
+
+/** \brief Free a handle allocated by eos_create() or eos_clone()
+ */
+void eos_destroy(eos_handle h);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
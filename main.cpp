@@ -25,14 +25,22 @@ using namespace o2scl;
 
 int main(int argc, char *argv[]) {
 
+#ifndef NO_MPI
+  MPI_Init(&argc,&argv);
+#endif
+
   cout.setf(ios::scientific);
 
   eos eph;
   cli cl;
-  
+
   eph.setup_cli(cl);
 
   cl.run_auto(argc,argv);
-  
+
+#ifndef NO_MPI
+  MPI_Finalize();
+#endif
+
   return 0;
 }
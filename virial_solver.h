@@ -22,6 +22,7 @@
 #define VIRIAL_SOLVER_H
 
 #include <cmath>
+#include <vector>
 
 #include <boost/numeric/ublas/vector.hpp>
 #include <boost/numeric/ublas/matrix.hpp>
@@ -46,11 +47,22 @@ public:
   double nn, pn, lambda, T, b_n, b_pn;
   double mfn2_mu_n, mfn2_mu_p, dbndT, zp, zn;
   double dbpndT, dlambdadT, npt, nnt, a, b, c, d, e;
-  ubmatrix A;
-  ubvector B;
+
+  /** \brief Stack-resident workspace for the 2x2 derivative
+      systems
+
+      The entries are stored in row-major order, i.e. \c mw[1] is
+      the (0,1) entry. Using a fixed array instead of resizable
+      ublas objects avoids a heap allocation on every derivative
+      solve.
+  */
+  double mw[4];
+
+  /// Right-hand side for the 2x2 derivative systems
+  double bw[2];
 
   /// Linear system solver
-  o2scl_linalg::linear_solver_LU<ubvector,ubmatrix> lsol;  
+  o2scl_linalg::linear_solver_LU<ubvector,ubmatrix> lsol;
 
   /// Quartic polynomial solver
   o2scl::quartic_real_coeff_cern quart;
@@ -230,35 +242,42 @@ public:
     return;
   }
 
+  /** \brief Build the 2x2 matrix for the derivative solves in
+      \ref mw
+
+      This matrix is shared by \ref mfn21(), \ref mfn31() and
+      \ref mfn41(), which previously built identical copies of
+      it.
+  */
+  void fill_deriv_matrix() {
+    double pre=2/pow(lambda,3);
+    mw[0]=pre*(zn/T+4*zn*zn*b_n/T+2*zp*zn*b_pn/T);
+    mw[1]=pre*2*zp*zn*b_pn/T;
+    mw[2]=pre*2*zp*zn*b_pn/T;
+    mw[3]=pre*(zp/T+4*zp*zp*b_n/T+2*zp*zn*b_pn/T);
+    return;
+  }
+
+  /// Solve the 2x2 system in \ref mw with right-hand side \ref bw
+  void solve_deriv_matrix(ubvector &x) {
+    double den=mw[0]*mw[3]-mw[1]*mw[2];
+    x[0]=(mw[3]*bw[0]-mw[1]*bw[1])/den;
+    x[1]=(mw[0]*bw[1]-mw[2]*bw[0])/den;
+    return;
+  }
+
   /** \brief Here, a brief description of this function
       derivative with respect to nn of mfn (linear solver)
   */
   double mfn21(ubvector &x2) {
     zn=exp(mfn2_mu_n/T);
     zp=exp(mfn2_mu_p/T);
-    A.resize(2,2);
-    B.resize(2);
-    A(0,0)=2/pow(lambda,3)*(zn/T+4*zn*zn*b_n/T+2*zp*zn*b_pn/T);
-    A(0,1)=2/pow(lambda,3)*2*zp*zn*b_pn/T;
-    A(1,0)=2/pow(lambda,3)*2*zp*zn*b_pn/T;
-    A(1,1)=2/pow(lambda,3)*(zp/T+4*zp*zp*b_n/T+2*zp*zn*b_pn/T);
-    /*std::cout<<"mfn21 start: "<<std::endl;
-      std::cout<<mfn2_mu_n<<" "<<mfn2_mu_p<<std::endl;
-      std::cout<<zn<<" "<<zp<<" "<<T<<std::endl;
-      std::cout<<"mfn21 end: "<<std::endl;*/
-    /*std::cout<<A(0,0)<<" "<<A(0,1)<<" "<<A(1,0)<<" "
-      <<A(1,1)<<std::endl;*/
-    B(0)=1;
-    B(1)=0;
-    if (true) {
-      double den=A(0,0)*A(1,1)-A(0,1)*A(1,0);
-      x2[0]=A(1,1)/den;
-      x2[1]=-A(1,0)/den;
-    } else {
-      lsol.solve(2,A,B,x2);
-    }
-    return 0;  
-     
+    fill_deriv_matrix();
+    bw[0]=1;
+    bw[1]=0;
+    solve_deriv_matrix(x2);
+    return 0;
+
   }
 
   /** \brief Here, a brief description of this function
@@ -267,25 +286,13 @@ public:
   double mfn31(ubvector &x3) {
     zn=exp(mfn2_mu_n/T);
     zp=exp(mfn2_mu_p/T);
-    A.resize(2,2);
-    B.resize(2);
-    A(0,0)=2/pow(lambda,3)*(zn/T+4*zn*zn*b_n/T+2*zp*zn*b_pn/T);
-    A(0,1)=2/pow(lambda,3)*2*zp*zn*b_pn/T;
-    A(1,0)=2/pow(lambda,3)*2*zp*zn*b_pn/T;
-    A(1,1)=2/pow(lambda,3)*(zp/T+4*zp*zp*b_n/T+2*zp*zn*b_pn/T);
-    B(0)=0;
-    B(1)=1;
-    if (true) {
-      double den=A(0,0)*A(1,1)-A(0,1)*A(1,0);
-      x3[0]=-A(0,1)/den;
-      x3[1]=A(0,0)/den;
-    } else {
-      lsol.solve(2,A,B,x3);
-    }
-
-    return 0;  
+    fill_deriv_matrix();
+    bw[0]=0;
+    bw[1]=1;
+    solve_deriv_matrix(x3);
+    return 0;
   }
-   
+
   /** \brief Here, a brief description of this function
       derivative with respect to T of mfn
   */
@@ -293,34 +300,25 @@ public:
     // dmundT=x4[0];
     // dmupdT=x4[1];
 
-    A(0,0)=2/pow(lambda,3)*(zn/T+4*zn*zn*b_n/T+2*zp*zn*b_pn/T);
-    A(0,1)=2/pow(lambda,3)*2*zp*zn*b_pn/T;
-    A(1,0)=2/pow(lambda,3)*2*zp*zn*b_pn/T;
-    A(1,1)=2/pow(lambda,3)*(zp/T+4*zp*zp*b_n/T+2*zp*zn*b_pn/T);
-    B(0)=-(2/pow(lambda,4)*(-3)*dlambdadT*
-	   (zn+2*zn*zn*b_n+
-	    2*zp*zn*b_pn)+2/pow(lambda,3)*
-	   (zn*(-mfn2_mu_n/T/T)+2*zn*zn*dbndT-
-	    4*zn*zn*b_n*mfn2_mu_n/T/T+
-	    2*zp*zn*dbpndT-
-	    2*zp*zn*b_pn*mfn2_mu_p/T/T-
-	    2*zp*zn*b_pn*mfn2_mu_n/T/T));
-    B(1)=-(2/pow(lambda,4)*(-3)*dlambdadT*
-	   (zp+2*zp*zp*b_n+
-	    2*zp*zn*b_pn)+2/pow(lambda,3)*
-	   (zp*(-mfn2_mu_p/T/T)+2*zp*zp*dbndT-
-	    4*zp*zp*b_n*mfn2_mu_p/T/T+
-	    2*zp*zn*dbpndT-
-	    2*zp*zn*b_pn*mfn2_mu_p/T/T-
-	    2*zp*zn*b_pn*mfn2_mu_n/T/T));
+    fill_deriv_matrix();
+    bw[0]=-(2/pow(lambda,4)*(-3)*dlambdadT*
+	    (zn+2*zn*zn*b_n+
+	     2*zp*zn*b_pn)+2/pow(lambda,3)*
+	    (zn*(-mfn2_mu_n/T/T)+2*zn*zn*dbndT-
+	     4*zn*zn*b_n*mfn2_mu_n/T/T+
+	     2*zp*zn*dbpndT-
+	     2*zp*zn*b_pn*mfn2_mu_p/T/T-
+	     2*zp*zn*b_pn*mfn2_mu_n/T/T));
+    bw[1]=-(2/pow(lambda,4)*(-3)*dlambdadT*
+	    (zp+2*zp*zp*b_n+
+	     2*zp*zn*b_pn)+2/pow(lambda,3)*
+	    (zp*(-mfn2_mu_p/T/T)+2*zp*zp*dbndT-
+	     4*zp*zp*b_n*mfn2_mu_p/T/T+
+	     2*zp*zn*dbpndT-
+	     2*zp*zn*b_pn*mfn2_mu_p/T/T-
+	     2*zp*zn*b_pn*mfn2_mu_n/T/T));
     nf++;
-    if (true) {
-      double den=A(0,0)*A(1,1)-A(0,1)*A(1,0);
-      x4[0]=(A(1,1)*B(0)-A(0,1)*B(1))/den;
-      x4[1]=(A(0,0)*B(1)-A(1,0)*B(0))/den;
-    } else {
-      lsol.solve(2,A,B,x4);
-    }
+    solve_deriv_matrix(x4);
     return 0;
   }
 
@@ -332,12 +330,225 @@ public:
 class virial_solver_new : public virial_solver {
 
 protected:
-  
+
   /// Storage for the four roots
-  std::complex<double> res_zp[4],res_zn[4]; 
-  
+  std::complex<double> res_zp[4],res_zn[4];
+
 public:
 
+  /// \name Counters for the batch solver paths
+  //@{
+  size_t n_batch_newton, n_batch_quartic, n_batch_scalar;
+  //@}
+
+  virial_solver_new() {
+    n_batch_newton=0;
+    n_batch_quartic=0;
+    n_batch_scalar=0;
+  }
+
+  /** \brief Polish a fugacity pair by Newton iteration on the
+      original two-dimensional system
+
+      The system solved is \f$ \tilde{n}_n = z_n + 2 z_n^2 b_n +
+      2 z_n z_p b_{pn} \f$ and \f$ \tilde{n}_p = z_p + 2 z_p^2
+      b_n + 2 z_n z_p b_{pn} \f$. On success the polished values
+      are stored in \c zn_g and \c zp_g and true is returned. If
+      the iteration leaves the positive quadrant or fails to
+      converge, false is returned and the guesses are unmodified.
+  */
+  bool polish_fugacity(double nnt_loc, double npt_loc,
+		       double b_n_loc, double b_pn_loc,
+		       double &zn_g, double &zp_g) {
+
+    double znl=zn_g, zpl=zp_g;
+    double tol=1.0e-10*(fabs(nnt_loc)+fabs(npt_loc));
+
+    for(int it=0;it<30;it++) {
+      double f1=znl+2.0*znl*znl*b_n_loc+2.0*znl*zpl*b_pn_loc-nnt_loc;
+      double f2=zpl+2.0*zpl*zpl*b_n_loc+2.0*znl*zpl*b_pn_loc-npt_loc;
+      if (fabs(f1)<=tol && fabs(f2)<=tol) {
+        zn_g=znl;
+        zp_g=zpl;
+        return true;
+      }
+      double j11=1.0+4.0*znl*b_n_loc+2.0*zpl*b_pn_loc;
+      double j12=2.0*znl*b_pn_loc;
+      double j21=2.0*zpl*b_pn_loc;
+      double j22=1.0+4.0*zpl*b_n_loc+2.0*znl*b_pn_loc;
+      double den=j11*j22-j12*j21;
+      if (den==0.0) return false;
+      znl-=(j22*f1-j12*f2)/den;
+      zpl-=(j11*f2-j21*f1)/den;
+      if (znl<=0.0 || zpl<=0.0) return false;
+    }
+
+    return false;
+  }
+
+  /** \brief Solve for one fugacity pair from precomputed quartic
+      coefficients using the closed-form solver
+
+      The coefficients must have been built with the larger of
+      the two scaled densities, as in \ref solve_fugacity_batch().
+      If \c prot is true the quartic variable is \f$ z_p \f$ and
+      the quadratic partner is \f$ z_n \f$, otherwise the roles
+      are swapped. On success the members \c zn and \c zp are set
+      and true is returned.
+  */
+  bool quartic_fugacity(bool prot, double a_loc, double b_loc,
+			double c_loc, double d_loc, double e_loc,
+			double lo, double b_n_loc, double b_pn_loc) {
+
+    std::complex<double> rts[4];
+    quart.solve_rc(a_loc,b_loc,c_loc,d_loc,e_loc,
+		   rts[0],rts[1],rts[2],rts[3]);
+
+    int res_index=-1;
+    double minsq=1.0e100, z1_best=0.0, z2_best=0.0;
+
+    for (int i=0;i<4;i++) {
+      if (rts[i].real()>0 &&
+	  fabs(rts[i].imag()/rts[i].real())<1.0e-6) {
+	double r0, r1, z2;
+	gsl_poly_solve_quadratic(2.0*b_n_loc,2.0*rts[i].real()*
+				 b_pn_loc+1.0,-lo,&r0,&r1);
+	if (r0>r1) z2=r0;
+	else z2=r1;
+	if (z2>0.0) {
+	  double temp=z2*z2+rts[i].real()*rts[i].real();
+	  if (temp<minsq) {
+	    minsq=temp;
+	    res_index=i;
+	    z1_best=rts[i].real();
+	    z2_best=z2;
+	  }
+	}
+      }
+    }
+
+    if (res_index<0) return false;
+
+    if (prot) {
+      zp=z1_best;
+      zn=z2_best;
+    } else {
+      zn=z1_best;
+      zp=z2_best;
+    }
+
+    return true;
+  }
+
+  /** \brief Solve for the fugacities for a batch of points
+
+      The input arrays hold \c n_pts values of the densities, the
+      temperature, the thermal wavelength, and the two virial
+      coefficients, laid out structure-of-arrays so that the
+      coefficient construction vectorizes across points. The
+      fugacities are stored in \c zn_arr and \c zp_arr.
+
+      For smoothly varying inputs (as in table generation) most
+      points are solved by polishing the previous point's roots
+      with \ref polish_fugacity(). Points without a usable seed
+      are solved with the closed-form quartic solver \ref quart
+      via \ref quartic_fugacity(), and any remaining failures
+      fall back to the scalar \ref solve_fugacity(). The counters
+      \ref n_batch_newton, \ref n_batch_quartic, and \ref
+      n_batch_scalar record how many points took each path.
+  */
+  virtual void solve_fugacity_batch(size_t n_pts,
+				    const std::vector<double> &nn_arr,
+				    const std::vector<double> &pn_arr,
+				    const std::vector<double> &T_arr,
+				    const std::vector<double> &lambda_arr,
+				    const std::vector<double> &b_n_arr,
+				    const std::vector<double> &b_pn_arr,
+				    std::vector<double> &zn_arr,
+				    std::vector<double> &zp_arr) {
+
+    zn_arr.resize(n_pts);
+    zp_arr.resize(n_pts);
+
+    // Structure-of-arrays storage for the scaled densities and
+    // the quartic coefficients
+    std::vector<double> nnv(n_pts), npv(n_pts), av(n_pts), bv(n_pts),
+      cv(n_pts), dv(n_pts), ev(n_pts);
+
+    for(size_t i=0;i<n_pts;i++) {
+      double lam3=lambda_arr[i]*lambda_arr[i]*lambda_arr[i];
+      nnv[i]=lam3/2.0*nn_arr[i];
+      npv[i]=lam3/2.0*pn_arr[i];
+      double hi=npv[i]>=nnv[i] ? npv[i] : nnv[i];
+      double lo=npv[i]>=nnv[i] ? nnv[i] : npv[i];
+      double bn2=b_n_arr[i], bpn2=b_pn_arr[i];
+      av[i]=bn2*bn2*bn2*2.0/bpn2/bpn2-2.0*bn2;
+      bv[i]=-1.0+bn2*bn2*2.0/bpn2/bpn2-bn2/bpn2;
+      cv[i]=bn2/(2.0*bpn2*bpn2)-0.5/bpn2-lo+hi-bn2*bn2*hi*2.0/bpn2/bpn2;
+      dv[i]=-bn2*hi/bpn2/bpn2+hi/2.0/bpn2;
+      ev[i]=bn2*hi*hi/2.0/bpn2/bpn2;
+    }
+
+    bool have_prev=false;
+    double zn_prev=0.0, zp_prev=0.0;
+    ubvector x(2);
+
+    for(size_t i=0;i<n_pts;i++) {
+
+      bool done=false;
+
+      // Warm start: polish the previous point's roots
+      if (have_prev) {
+	double zng=zn_prev, zpg=zp_prev;
+	if (polish_fugacity(nnv[i],npv[i],b_n_arr[i],b_pn_arr[i],
+			    zng,zpg)) {
+	  zn=zng;
+	  zp=zpg;
+	  done=true;
+	  n_batch_newton++;
+	}
+      }
+
+      // Cold start: closed-form quartic on the precomputed
+      // coefficients, polished afterwards
+      if (done==false) {
+	bool prot=npv[i]>=nnv[i];
+	double lo=prot ? nnv[i] : npv[i];
+	if (quartic_fugacity(prot,av[i],bv[i],cv[i],dv[i],ev[i],
+			     lo,b_n_arr[i],b_pn_arr[i])) {
+	  double zng=zn, zpg=zp;
+	  if (polish_fugacity(nnv[i],npv[i],b_n_arr[i],b_pn_arr[i],
+			      zng,zpg)) {
+	    zn=zng;
+	    zp=zpg;
+	  }
+	  done=true;
+	  n_batch_quartic++;
+	}
+      }
+
+      // Last resort: the scalar solver
+      if (done==false) {
+	nn=nn_arr[i];
+	pn=pn_arr[i];
+	T=T_arr[i];
+	lambda=lambda_arr[i];
+	b_n=b_n_arr[i];
+	b_pn=b_pn_arr[i];
+	solve_fugacity(x);
+	n_batch_scalar++;
+      }
+
+      zn_arr[i]=zn;
+      zp_arr[i]=zp;
+      zn_prev=zn;
+      zp_prev=zp;
+      have_prev=true;
+    }
+
+    return;
+  }
+
   virtual void solve_fugacity(ubvector &x) {
 
 